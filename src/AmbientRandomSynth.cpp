@@ -1,4 +1,6 @@
 #include "plugin.hpp"
+#include "ClockTransport.hpp"
+#include "FastMath.hpp"
 #include <vector>
 #include <algorithm>
 #include <cmath>
@@ -82,7 +84,7 @@ struct AmbientRandomSynth : Module {
 			for (int i = 0; i < 3; i++) {
 				phase[i] += freq * detunes[i] * dt;
 				if (phase[i] >= 1.f) phase[i] -= 1.f;
-				out += std::sin(2.f * M_PI * phase[i]);
+				out += FastMath::sin2pi(phase[i]);
 			}
 			return out / 3.f * env;
 		}
@@ -102,6 +104,8 @@ struct AmbientRandomSynth : Module {
 	dsp::SchmittTrigger resetBtnTrigger;
 	dsp::SchmittTrigger freezeBtnTrigger;
 	bool freeze = false;
+	// 相邻 MidiClockSync 的走带信息（CLK 未接线时代替内部节拍）
+	ClockTransport::Receiver transport;
 	
 	float lastVoct = 0.f;
 	float gateTimer = 0.f;
@@ -117,6 +121,7 @@ struct AmbientRandomSynth : Module {
 
 	AmbientRandomSynth() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		
 		configParam(TEMPO_PARAM, 20.f, 180.f, 60.f, "Tempo", " BPM");
 		configParam(DENSITY_PARAM, 0.f, 1.f, 0.4f, "Density");
@@ -196,7 +201,12 @@ struct AmbientRandomSynth : Module {
 		float interval = (60.f / tempo) * 0.5f; 
 		
 		bool tick = false;
-		if (clkTrigger.process(inputs[CLK_INPUT].getVoltage())) {
+		bool transportSync = transport.process(this, args.frame) && !inputs[CLK_INPUT].isConnected();
+		if (transportSync) {
+			// 与内部节拍相同的八分音符，位置直接取自走带
+			tick = transport.crossed(ClockTransport::TICKS_PER_BEAT * 0.5);
+			tickTimer = 0.f;
+		} else if (clkTrigger.process(inputs[CLK_INPUT].getVoltage())) {
 			tick = true;
 		} else {
 			tickTimer += args.sampleTime;
@@ -0,0 +1,595 @@
+#include "plugin.hpp"
+#include "AudioFileDecoder.hpp"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+
+namespace AudioFileDecoder {
+
+// Samples are converted in blocks of this many values
+static constexpr int BLOCK_SIZE = 4096;
+
+// --- Byte helpers ---
+static inline uint16_t readLE16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t readLE32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline uint16_t readBE16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+static inline uint32_t readBE32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+
+static bool readWholeFile(const std::string& path, std::vector<uint8_t>& data) {
+	FILE* f = std::fopen(path.c_str(), "rb");
+	if (!f) return false;
+	std::fseek(f, 0, SEEK_END);
+	long size = std::ftell(f);
+	std::fseek(f, 0, SEEK_SET);
+	if (size <= 0) { std::fclose(f); return false; }
+	data.resize((size_t)size);
+	size_t got = std::fread(data.data(), 1, data.size(), f);
+	std::fclose(f);
+	data.resize(got);
+	return got > 0;
+}
+
+// --- Block conversion ---
+
+// Left-justified int32 -> float, four values at a time
+static void convertInt32Block(const int32_t* in, float* out, int count) {
+	const float scale = 1.f / 2147483648.f;
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		simd::float_4 v = simd::float_4(simd::int32_4::load(in + i));
+		(v * scale).store(out + i);
+	}
+	for (; i < count; i++)
+		out[i] = (float)in[i] * scale;
+}
+
+enum SampleFormat {
+	FORMAT_PCM,
+	FORMAT_FLOAT
+};
+
+// Converts `count` packed samples starting at `src` into out.
+// Integer samples are first unpacked into a left-justified int32 block so that
+// every bit depth shares the same SIMD conversion.
+static bool convertPacked(const uint8_t* src, size_t count, int bits, SampleFormat format, bool bigEndian, bool unsigned8, float* out) {
+	int bytes = bits / 8;
+	if (format == FORMAT_FLOAT) {
+		if (bits != 32 && bits != 64) return false;
+		for (size_t i = 0; i < count; i++) {
+			const uint8_t* p = src + i * bytes;
+			uint8_t b[8];
+			for (int k = 0; k < bytes; k++)
+				b[k] = bigEndian ? p[bytes - 1 - k] : p[k];
+			if (bits == 32) {
+				float v;
+				std::memcpy(&v, b, 4);
+				out[i] = v;
+			} else {
+				double v;
+				std::memcpy(&v, b, 8);
+				out[i] = (float)v;
+			}
+		}
+		return true;
+	}
+
+	if (bits != 8 && bits != 16 && bits != 24 && bits != 32) return false;
+	int32_t block[BLOCK_SIZE];
+	for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+		int n = (int)std::min((size_t)BLOCK_SIZE, count - start);
+		const uint8_t* p = src + start * bytes;
+		for (int i = 0; i < n; i++, p += bytes) {
+			uint32_t v = 0;
+			if (bigEndian) {
+				for (int k = 0; k < bytes; k++)
+					v = (v << 8) | p[k];
+			} else {
+				for (int k = bytes - 1; k >= 0; k--)
+					v = (v << 8) | p[k];
+			}
+			if (bits == 8 && unsigned8)
+				v ^= 0x80;
+			block[i] = (int32_t)(v << (32 - bits));
+		}
+		convertInt32Block(block, out + start, n);
+	}
+	return true;
+}
+
+// Common tail of the WAV and AIFF paths: the data region is trimmed to whole frames
+static bool decodePacked(const uint8_t* data, size_t dataSize, int channels, int bits, SampleFormat format, bool bigEndian, bool unsigned8, Audio& out) {
+	if (channels <= 0 || bits <= 0 || bits % 8 != 0) return false;
+	size_t frameBytes = (size_t)channels * (bits / 8);
+	size_t frames = dataSize / frameBytes;
+	if (frames == 0) return false;
+	out.channels = channels;
+	out.frames = (int)frames;
+	out.samples.resize(frames * channels);
+	return convertPacked(data, frames * channels, bits, format, bigEndian, unsigned8, out.samples.data());
+}
+
+// --- WAV ---
+
+static bool decodeWav(const std::vector<uint8_t>& file, Audio& out) {
+	const uint8_t* d = file.data();
+	size_t size = file.size();
+	if (size < 12) return false;
+
+	int formatTag = 0, channels = 0, bits = 0;
+	bool foundFmt = false;
+	size_t pos = 12;
+	while (pos + 8 <= size) {
+		const uint8_t* id = d + pos;
+		size_t chunkSize = readLE32(d + pos + 4);
+		size_t body = pos + 8;
+		// Streamed files may leave the data size unset; clamp to what is on disk
+		size_t avail = std::min(chunkSize, size - body);
+
+		if (std::memcmp(id, "fmt ", 4) == 0 && avail >= 16) {
+			formatTag = readLE16(d + body);
+			channels = readLE16(d + body + 2);
+			out.sampleRate = (int)readLE32(d + body + 4);
+			bits = readLE16(d + body + 14);
+			// WAVE_FORMAT_EXTENSIBLE: the real format code is the start of the sub-format GUID
+			if (formatTag == 0xFFFE && avail >= 26)
+				formatTag = readLE16(d + body + 24);
+			foundFmt = true;
+		} else if (std::memcmp(id, "data", 4) == 0) {
+			if (!foundFmt) return false;
+			if (formatTag == 1)
+				return decodePacked(d + body, avail, channels, bits, FORMAT_PCM, false, bits == 8, out);
+			if (formatTag == 3)
+				return decodePacked(d + body, avail, channels, bits, FORMAT_FLOAT, false, false, out);
+			return false;
+		}
+		// Chunks are padded to an even size
+		pos = body + chunkSize + (chunkSize & 1);
+	}
+	return false;
+}
+
+// --- AIFF / AIFC ---
+
+// 80-bit IEEE 754 extended precision, as used by the AIFF COMM chunk
+static double readExtended(const uint8_t* p) {
+	int exponent = ((p[0] & 0x7F) << 8) | p[1];
+	uint64_t mantissa = 0;
+	for (int i = 0; i < 8; i++)
+		mantissa = (mantissa << 8) | p[2 + i];
+	if (exponent == 0 && mantissa == 0) return 0.0;
+	double v = std::ldexp((double)mantissa, exponent - 16383 - 63);
+	return (p[0] & 0x80) ? -v : v;
+}
+
+static bool decodeAiff(const std::vector<uint8_t>& file, Audio& out) {
+	const uint8_t* d = file.data();
+	size_t size = file.size();
+	if (size < 12) return false;
+	bool aifc = std::memcmp(d + 8, "AIFC", 4) == 0;
+
+	int channels = 0, bits = 0;
+	SampleFormat format = FORMAT_PCM;
+	bool bigEndian = true;
+	bool foundComm = false;
+	size_t pos = 12;
+	while (pos + 8 <= size) {
+		const uint8_t* id = d + pos;
+		size_t chunkSize = readBE32(d + pos + 4);
+		size_t body = pos + 8;
+		size_t avail = std::min(chunkSize, size - body);
+
+		if (std::memcmp(id, "COMM", 4) == 0 && avail >= 18) {
+			channels = readBE16(d + body);
+			bits = readBE16(d + body + 6);
+			out.sampleRate = (int)std::round(readExtended(d + body + 8));
+			if (aifc && avail >= 22) {
+				const uint8_t* comp = d + body + 18;
+				if (std::memcmp(comp, "NONE", 4) == 0) {
+				} else if (std::memcmp(comp, "sowt", 4) == 0) {
+					bigEndian = false;
+				} else if (std::memcmp(comp, "fl32", 4) == 0 || std::memcmp(comp, "FL32", 4) == 0) {
+					format = FORMAT_FLOAT;
+					bits = 32;
+				} else if (std::memcmp(comp, "fl64", 4) == 0 || std::memcmp(comp, "FL64", 4) == 0) {
+					format = FORMAT_FLOAT;
+					bits = 64;
+				} else {
+					return false;
+				}
+			}
+			// Sample sizes that are not a whole number of bytes are stored left-justified
+			bits = (bits + 7) / 8 * 8;
+			foundComm = true;
+		} else if (std::memcmp(id, "SSND", 4) == 0 && avail >= 8) {
+			if (!foundComm) return false;
+			size_t offset = readBE32(d + body);
+			if (8 + offset > avail) return false;
+			return decodePacked(d + body + 8 + offset, avail - 8 - offset, channels, bits, format, bigEndian, false, out);
+		}
+		pos = body + chunkSize + (chunkSize & 1);
+	}
+	return false;
+}
+
+// --- FLAC ---
+
+// MSB-first bit reader over the whole file
+struct BitReader {
+	const uint8_t* data;
+	size_t size;
+	size_t bitPos = 0;
+	bool overrun = false;
+
+	BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	// Next 64 bits starting at bitPos (zero-padded past the end); at least 57 are valid
+	uint64_t peek64() const {
+		size_t byte = bitPos >> 3;
+		uint64_t v = 0;
+		if (byte + 8 <= size) {
+			for (int i = 0; i < 8; i++)
+				v = (v << 8) | data[byte + i];
+		} else {
+			for (int i = 0; i < 8; i++)
+				v = (v << 8) | (byte + i < size ? data[byte + i] : 0);
+		}
+		return v << (bitPos & 7);
+	}
+
+	uint32_t read(int n) {
+		if (n == 0) return 0;
+		uint64_t v = peek64();
+		bitPos += n;
+		if (bitPos > size * 8) overrun = true;
+		return (uint32_t)(v >> (64 - n));
+	}
+
+	int32_t readSigned(int n) {
+		if (n == 0) return 0;
+		uint32_t v = read(n);
+		// Sign-extend from n bits
+		return (int32_t)(v << (32 - n)) >> (32 - n);
+	}
+
+	// Up to 33 bits: the side channel of a 32-bit stream needs one extra bit
+	int64_t readSample(int n) {
+		if (n <= 32) return readSigned(n);
+		int64_t high = readSigned(n - 32);
+		return (int64_t)((uint64_t)high << 32) | read(32);
+	}
+
+	// Number of 0 bits before the next 1 bit (which is consumed)
+	uint32_t readUnary() {
+		uint32_t count = 0;
+		while (true) {
+			if (bitPos >= size * 8) {
+				overrun = true;
+				return count;
+			}
+			int valid = 64 - (int)(bitPos & 7);
+			uint64_t v = peek64();
+			if (v != 0) {
+				int zeros = __builtin_clzll(v);
+				if (zeros < valid) {
+					count += zeros;
+					bitPos += zeros + 1;
+					return count;
+				}
+			}
+			count += valid;
+			bitPos += valid;
+		}
+	}
+
+	void alignToByte() {
+		bitPos = (bitPos + 7) & ~(size_t)7;
+	}
+
+	bool atEnd() const {
+		return overrun || bitPos >= size * 8;
+	}
+};
+
+struct FlacStreamInfo {
+	int sampleRate = 0;
+	int channels = 0;
+	int bits = 0;
+	uint64_t totalFrames = 0;
+};
+
+// Residual with partitioned Rice coding (RICE and RICE2 methods)
+static bool flacReadResidual(BitReader& br, int blockSize, int order, int64_t* residual) {
+	int method = (int)br.read(2);
+	if (method > 1) return false;
+	int paramBits = (method == 0) ? 4 : 5;
+	int escape = (method == 0) ? 15 : 31;
+	int partitionOrder = (int)br.read(4);
+	int partitions = 1 << partitionOrder;
+	int partitionSize = blockSize >> partitionOrder;
+	if (partitionSize < order) return false;
+
+	int i = 0;
+	for (int p = 0; p < partitions; p++) {
+		int n = partitionSize - (p == 0 ? order : 0);
+		int param = (int)br.read(paramBits);
+		if (param == escape) {
+			int bits = (int)br.read(5);
+			for (int k = 0; k < n; k++)
+				residual[i++] = br.readSigned(bits);
+		} else {
+			for (int k = 0; k < n; k++) {
+				uint32_t q = br.readUnary();
+				uint32_t v = (q << param) | br.read(param);
+				// Zigzag decode
+				residual[i++] = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+			}
+		}
+		if (br.overrun) return false;
+	}
+	return true;
+}
+
+static bool flacReadSubframe(BitReader& br, int blockSize, int bits, int64_t* out) {
+	if (br.read(1) != 0) return false;
+	int type = (int)br.read(6);
+	int wasted = 0;
+	if (br.read(1)) {
+		wasted = (int)br.readUnary() + 1;
+		bits -= wasted;
+	}
+	if (bits <= 0 || bits > 33) return false;
+
+	if (type == 0) {
+		// CONSTANT
+		int64_t v = br.readSample(bits);
+		for (int i = 0; i < blockSize; i++)
+			out[i] = v;
+	} else if (type == 1) {
+		// VERBATIM
+		for (int i = 0; i < blockSize; i++)
+			out[i] = br.readSample(bits);
+	} else if (type >= 8 && type <= 12) {
+		// FIXED predictor, order 0-4
+		int order = type - 8;
+		if (order > blockSize) return false;
+		for (int i = 0; i < order; i++)
+			out[i] = br.readSample(bits);
+		if (!flacReadResidual(br, blockSize, order, out + order)) return false;
+		switch (order) {
+			case 1:
+				for (int i = 1; i < blockSize; i++) out[i] += out[i - 1];
+				break;
+			case 2:
+				for (int i = 2; i < blockSize; i++) out[i] += 2 * out[i - 1] - out[i - 2];
+				break;
+			case 3:
+				for (int i = 3; i < blockSize; i++) out[i] += 3 * out[i - 1] - 3 * out[i - 2] + out[i - 3];
+				break;
+			case 4:
+				for (int i = 4; i < blockSize; i++) out[i] += 4 * out[i - 1] - 6 * out[i - 2] + 4 * out[i - 3] - out[i - 4];
+				break;
+			default:
+				break;
+		}
+	} else if (type >= 32) {
+		// LPC, order 1-32
+		int order = type - 31;
+		if (order > blockSize) return false;
+		for (int i = 0; i < order; i++)
+			out[i] = br.readSample(bits);
+		int precision = (int)br.read(4) + 1;
+		if (precision == 16) return false;
+		int shift = br.readSigned(5);
+		if (shift < 0) return false;
+		int64_t coefs[32];
+		for (int i = 0; i < order; i++)
+			coefs[i] = br.readSigned(precision);
+		if (!flacReadResidual(br, blockSize, order, out + order)) return false;
+		for (int i = order; i < blockSize; i++) {
+			int64_t sum = 0;
+			for (int j = 0; j < order; j++)
+				sum += coefs[j] * out[i - 1 - j];
+			out[i] += sum >> shift;
+		}
+	} else {
+		return false;
+	}
+
+	if (wasted > 0) {
+		for (int i = 0; i < blockSize; i++)
+			out[i] <<= wasted;
+	}
+	return !br.overrun;
+}
+
+// Decodes one frame and appends it to out.samples. Returns false at the end of the stream or on error.
+static bool flacReadFrame(BitReader& br, const FlacStreamInfo& info, std::vector<int64_t>& channelBuf, Audio& out) {
+	br.alignToByte();
+	// Scan for the 14-bit frame sync code
+	while (!br.atEnd()) {
+		size_t byte = br.bitPos >> 3;
+		if (byte + 1 < br.size && br.data[byte] == 0xFF && (br.data[byte + 1] & 0xFC) == 0xF8)
+			break;
+		br.bitPos += 8;
+	}
+	if (br.atEnd()) return false;
+
+	br.read(14);
+	br.read(1);                       // reserved
+	br.read(1);                       // blocking strategy
+	int blockSizeCode = (int)br.read(4);
+	int sampleRateCode = (int)br.read(4);
+	int channelAssign = (int)br.read(4);
+	int sampleSizeCode = (int)br.read(3);
+	br.read(1);                       // reserved
+
+	// Frame/sample number, UTF-8 style coding; only skipped
+	uint32_t first = br.read(8);
+	int extra = 0;
+	while (extra < 7 && (first & (0x80 >> extra))) extra++;
+	for (int i = 1; i < extra; i++) br.read(8);
+
+	int blockSize = 0;
+	if (blockSizeCode == 1) blockSize = 192;
+	else if (blockSizeCode >= 2 && blockSizeCode <= 5) blockSize = 576 << (blockSizeCode - 2);
+	else if (blockSizeCode == 6) blockSize = (int)br.read(8) + 1;
+	else if (blockSizeCode == 7) blockSize = (int)br.read(16) + 1;
+	else if (blockSizeCode >= 8) blockSize = 256 << (blockSizeCode - 8);
+	else return false;
+
+	if (sampleRateCode == 12) br.read(8);
+	else if (sampleRateCode == 13 || sampleRateCode == 14) br.read(16);
+	br.read(8);                       // header CRC-8
+
+	static const int sampleSizes[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+	int bits = (sampleSizeCode == 0) ? info.bits : sampleSizes[sampleSizeCode];
+	if (bits == 0) return false;
+
+	int channels = (channelAssign < 8) ? channelAssign + 1 : 2;
+	if (channelAssign > 10 || channels != info.channels) return false;
+
+	channelBuf.resize((size_t)blockSize * channels);
+	for (int ch = 0; ch < channels; ch++) {
+		// The side channel carries one extra bit
+		bool side = (channelAssign == 8 && ch == 1) || (channelAssign == 9 && ch == 0) || (channelAssign == 10 && ch == 1);
+		if (!flacReadSubframe(br, blockSize, bits + (side ? 1 : 0), channelBuf.data() + (size_t)ch * blockSize))
+			return false;
+	}
+	br.alignToByte();
+	br.read(16);                      // frame CRC-16
+
+	int64_t* a = channelBuf.data();
+	int64_t* b = channelBuf.data() + blockSize;
+	if (channelAssign == 8) {
+		// left/side
+		for (int i = 0; i < blockSize; i++) b[i] = a[i] - b[i];
+	} else if (channelAssign == 9) {
+		// side/right
+		for (int i = 0; i < blockSize; i++) a[i] += b[i];
+	} else if (channelAssign == 10) {
+		// mid/side
+		for (int i = 0; i < blockSize; i++) {
+			int64_t mid = (a[i] << 1) | (b[i] & 1);
+			int64_t side = b[i];
+			a[i] = (mid + side) >> 1;
+			b[i] = (mid - side) >> 1;
+		}
+	}
+
+	// Interleave into a left-justified int32 block, then convert
+	int32_t block[BLOCK_SIZE];
+	size_t base = out.samples.size();
+	out.samples.resize(base + (size_t)blockSize * channels);
+	float* dst = out.samples.data() + base;
+	int shift = 32 - bits;
+	size_t total = (size_t)blockSize * channels;
+	for (size_t start = 0; start < total; start += BLOCK_SIZE) {
+		int n = (int)std::min((size_t)BLOCK_SIZE, total - start);
+		for (int k = 0; k < n; k++) {
+			size_t idx = start + k;
+			size_t frame = idx / channels;
+			int ch = (int)(idx % channels);
+			block[k] = (int32_t)((uint32_t)channelBuf[(size_t)ch * blockSize + frame] << shift);
+		}
+		convertInt32Block(block, dst + start, n);
+	}
+	out.frames += blockSize;
+	return true;
+}
+
+static bool decodeFlac(const std::vector<uint8_t>& file, Audio& out) {
+	BitReader br(file.data(), file.size());
+
+	// Skip an ID3v2 tag if present (size is a 28-bit syncsafe integer)
+	if (file.size() >= 10 && std::memcmp(file.data(), "ID3", 3) == 0) {
+		const uint8_t* p = file.data() + 6;
+		size_t tagSize = ((size_t)(p[0] & 0x7F) << 21) | ((size_t)(p[1] & 0x7F) << 14) | ((size_t)(p[2] & 0x7F) << 7) | (p[3] & 0x7F);
+		br.bitPos = (10 + tagSize) * 8;
+	}
+	size_t start = br.bitPos >> 3;
+	if (start + 4 > file.size() || std::memcmp(file.data() + start, "fLaC", 4) != 0) return false;
+	br.bitPos += 32;
+
+	FlacStreamInfo info;
+	bool last = false;
+	while (!last && !br.atEnd()) {
+		last = br.read(1) != 0;
+		int type = (int)br.read(7);
+		uint32_t length = br.read(24);
+		size_t next = br.bitPos + (size_t)length * 8;
+		if (type == 0) {
+			br.read(16);              // min block size
+			br.read(16);              // max block size
+			br.read(24);              // min frame size
+			br.read(24);              // max frame size
+			info.sampleRate = (int)br.read(20);
+			info.channels = (int)br.read(3) + 1;
+			info.bits = (int)br.read(5) + 1;
+			info.totalFrames = ((uint64_t)br.read(4) << 32) | br.read(32);
+		}
+		br.bitPos = next;
+	}
+	if (info.sampleRate == 0 || info.channels == 0) return false;
+
+	out.sampleRate = info.sampleRate;
+	out.channels = info.channels;
+	out.frames = 0;
+	out.samples.clear();
+	if (info.totalFrames > 0)
+		out.samples.reserve((size_t)info.totalFrames * info.channels);
+
+	std::vector<int64_t> channelBuf;
+	while (flacReadFrame(br, info, channelBuf, out)) {}
+	return out.frames > 0;
+}
+
+// --- Public API ---
+
+bool decode(const std::string& path, Audio& out) {
+	std::vector<uint8_t> file;
+	if (!readWholeFile(path, file) || file.size() < 12) return false;
+	out = Audio();
+
+	const uint8_t* d = file.data();
+	bool ok = false;
+	if (std::memcmp(d, "RIFF", 4) == 0 && std::memcmp(d + 8, "WAVE", 4) == 0)
+		ok = decodeWav(file, out);
+	else if (std::memcmp(d, "FORM", 4) == 0 && (std::memcmp(d + 8, "AIFF", 4) == 0 || std::memcmp(d + 8, "AIFC", 4) == 0))
+		ok = decodeAiff(file, out);
+	else
+		ok = decodeFlac(file, out);
+
+	if (!ok || out.sampleRate <= 0 || out.channels <= 0 || out.frames <= 0) {
+		out = Audio();
+		return false;
+	}
+	return true;
+}
+
+void mixToMono(const Audio& in, std::vector<float>& out) {
+	out.resize(in.frames);
+	if (in.channels == 1) {
+		std::copy(in.samples.begin(), in.samples.begin() + in.frames, out.begin());
+		return;
+	}
+	float gain = 1.f / in.channels;
+	const float* src = in.samples.data();
+	for (int i = 0; i < in.frames; i++) {
+		float sum = 0.f;
+		for (int ch = 0; ch < in.channels; ch++)
+			sum += src[ch];
+		out[i] = sum * gain;
+		src += in.channels;
+	}
+}
+
+bool isSupportedExtension(const std::string& ext) {
+	std::string e = ext;
+	std::transform(e.begin(), e.end(), e.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return e == ".wav" || e == ".wave" || e == ".aif" || e == ".aiff" || e == ".aifc" || e == ".flac";
+}
+
+} // namespace AudioFileDecoder
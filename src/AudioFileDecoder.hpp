@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Shared sample file decoder used by OrganicParticleSynth and WT_SURGE_X.
+//
+// Supported containers/encodings:
+//   WAV  - PCM 8/16/24/32-bit, IEEE float 32/64-bit, WAVE_FORMAT_EXTENSIBLE
+//   AIFF - PCM 8/16/24/32-bit (big-endian)
+//   AIFC - NONE, sowt (little-endian PCM), fl32, fl64
+//   FLAC - native FLAC streams, 4-32 bit, up to 8 channels
+//
+// The whole file is read with a single fread, then converted in blocks.
+// Decoding allocates and may take a while on long files, so call it from a
+// worker thread, never from Module::process().
+namespace AudioFileDecoder {
+
+struct Audio {
+	int sampleRate = 0;
+	int channels = 0;
+	int frames = 0;
+	// Interleaved samples in [-1, 1), frames * channels values
+	std::vector<float> samples;
+};
+
+// Detects the format from the file header. Returns false if the file cannot
+// be read or the format/encoding is not supported.
+bool decode(const std::string& path, Audio& out);
+
+// Averages all channels of `in` into `out`
+void mixToMono(const Audio& in, std::vector<float>& out);
+
+// File dialog filter covering every supported extension
+static const char* const DIALOG_FILTERS = "Audio files (WAV, AIFF, FLAC):wav,wave,aif,aiff,aifc,flac";
+
+// Case-insensitive check of the file extension (including the dot)
+bool isSupportedExtension(const std::string& ext);
+
+} // namespace AudioFileDecoder
@@ -0,0 +1,71 @@
+#pragma once
+#include "plugin.hpp"
+
+// Band-limited oscillator shapes shared by BasicOscillator, the chord synth
+// voices and ChordSynth's LFO.
+//
+// The naive shapes get polynomial corrections (PolyBLEP for steps, PolyBLAMP
+// for slope changes) over the two samples around each periodic edge. Every
+// function is a template over float and simd::float_4, so one call handles
+// four lanes where the caller has them.
+//
+// `phase` is in [0, 1) and `dt` is the phase increment per sample. The
+// correction assumes 0 < dt < 0.5, which is why the shapes clamp it. For
+// discontinuities that are not periodic (hard sync, phase resets), use
+// dsp::MinBlepGenerator with the jump height instead.
+namespace BandLimited {
+
+// Residual of a band-limited step at phase 0, in units of half the step height:
+// -1..0 in the sample after the edge, 0..1 in the sample before it
+template <typename T>
+inline T polyBlep(T phase, T dt) {
+	T after = phase / dt;
+	T before = (phase - 1.f) / dt;
+	return simd::ifelse(phase < dt, 2.f * after - after * after - 1.f,
+		simd::ifelse(phase > 1.f - dt, before * before + 2.f * before + 1.f, T(0.f)));
+}
+
+// Integral of polyBlep() over samples: residual of a band-limited corner for a
+// slope change of 2 per sample
+template <typename T>
+inline T polyBlamp(T phase, T dt) {
+	T after = 1.f - phase / dt;
+	T before = 1.f + (phase - 1.f) / dt;
+	return simd::ifelse(phase < dt, after * after * after * (1.f / 3.f),
+		simd::ifelse(phase > 1.f - dt, before * before * before * (1.f / 3.f), T(0.f)));
+}
+
+template <typename T>
+inline T wrap(T phase) {
+	return phase - simd::floor(phase);
+}
+
+template <typename T>
+inline T clampIncrement(T dt) {
+	return simd::fmin(simd::fmax(simd::fabs(dt), T(1e-6f)), T(0.499f));
+}
+
+// 2 * phase - 1, falling edge at phase 0
+template <typename T>
+inline T saw(T phase, T dt) {
+	dt = clampIncrement(dt);
+	return 2.f * phase - 1.f - polyBlep(phase, dt);
+}
+
+// +1 for phase < 0.5, rising edge at 0, falling edge at 0.5
+template <typename T>
+inline T square(T phase, T dt) {
+	dt = clampIncrement(dt);
+	T naive = simd::ifelse(phase < 0.5f, T(1.f), T(-1.f));
+	return naive + polyBlep(phase, dt) - polyBlep(wrap(phase + 0.5f), dt);
+}
+
+// -1 at phase 0, +1 at phase 0.5. The slope changes by +-8 per cycle, 8 * dt per sample
+template <typename T>
+inline T triangle(T phase, T dt) {
+	dt = clampIncrement(dt);
+	T naive = simd::ifelse(phase < 0.5f, 4.f * phase - 1.f, 3.f - 4.f * phase);
+	return naive + 4.f * dt * (polyBlamp(phase, dt) - polyBlamp(wrap(phase + 0.5f), dt));
+}
+
+} // namespace BandLimited
@@ -1,4 +1,99 @@
 #include "plugin.hpp"
+#include "BandLimitedOscillator.hpp"
+#include "FastMath.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Band-limited single-cycle tables for the square, triangle and saw modes.
+// Each mip level holds two tables: the base shape and the normalized sum of its
+// harmonic copies at 2x..(N+1)x, so the Harmonic Strength knob stays a plain crossfade
+// and only the waveform or harmonic count trigger a rebuild. Level L keeps the
+// partials below SIZE / 2 >> L; the reader picks the lowest level whose top
+// partial is still under Nyquist.
+struct BandLimitedTables {
+	static constexpr int SIZE = 2048;
+	static constexpr int LEVELS = 11;
+	static constexpr int STRIDE = SIZE + 1; // one wrap sample for interpolation
+
+	int key = -1;
+	// [level][base, harmonics][STRIDE]
+	std::vector<float> data;
+
+	// Additive render from the shape's Fourier series. Slow (~10M multiply-adds),
+	// call from a worker thread. `shape` uses BasicOscillator::WaveformType values.
+	void render(int shape, int harmonicCount, int newKey) {
+		data.assign(LEVELS * 2 * STRIDE, 0.f);
+		std::vector<float> sinTable(SIZE);
+		for (int i = 0; i < SIZE; i++)
+			sinTable[i] = std::sin(2.f * M_PI * i / SIZE);
+
+		// Partial amplitudes of the base shape (square/saw: sine terms, triangle: cosine terms)
+		const int maxPartial = SIZE / 2;
+		std::vector<float> base(maxPartial + 1, 0.f);
+		for (int k = 1; k <= maxPartial; k++) {
+			if (shape == 1 && (k & 1))
+				base[k] = 4.f / (M_PI * k);
+			else if (shape == 2 && (k & 1))
+				base[k] = -8.f / (M_PI * M_PI * k * k);
+			else if (shape == 3)
+				base[k] = -2.f / (M_PI * k);
+		}
+		// Harmonic copy h+1 puts partial k of the shape at k * (h + 1), weighted 1/(h+1)
+		std::vector<float> harmonics(maxPartial + 1, 0.f);
+		float totalAmplitude = 0.f;
+		for (int h = 1; h <= harmonicCount; h++)
+			totalAmplitude += 1.f / (h + 1);
+		for (int h = 1; h <= harmonicCount; h++) {
+			float amplitude = 1.f / (h + 1) / totalAmplitude;
+			for (int k = 1; k * (h + 1) <= maxPartial; k++)
+				harmonics[k * (h + 1)] += amplitude * base[k];
+		}
+
+		// Triangle partials are cosines: offset the lookup by a quarter cycle
+		int quarter = shape == 2 ? SIZE / 4 : 0;
+		for (int level = 0; level < LEVELS; level++) {
+			int partials = maxPartial >> level;
+			float* out[2] = {&data[(level * 2) * STRIDE], &data[(level * 2 + 1) * STRIDE]};
+			const std::vector<float>* spectra[2] = {&base, &harmonics};
+			for (int t = 0; t < 2; t++) {
+				for (int m = 1; m <= partials; m++) {
+					float a = (*spectra[t])[m];
+					if (a == 0.f)
+						continue;
+					for (int i = 0; i < SIZE; i++)
+						out[t][i] += a * sinTable[(m * i + quarter) & (SIZE - 1)];
+				}
+				out[t][SIZE] = out[t][0];
+			}
+		}
+		key = newKey;
+	}
+
+	// Level whose partials all stay below Nyquist, for four lanes of `freq` at once.
+	// ceil(log2(ratio)) comes from the float bits: adding the largest mantissa carries
+	// into the exponent unless the ratio is an exact power of two.
+	static simd::float_4 levelsFor(simd::float_4 freq, float sampleRate) {
+		simd::float_4 ratio = simd::fmax(simd::fabs(freq) * ((float)SIZE / sampleRate), 1.f);
+		simd::int32_4 bits = simd::int32_4::cast(ratio);
+		simd::float_4 level = simd::float_4((bits + 0x007fffff) >> 23) - 127.f;
+		return simd::fmin(level, (float)(LEVELS - 1));
+	}
+
+	// Linear-interpolated read, crossfading base and harmonic tables by `strength`
+	float read(int level, float phase, float strength) const {
+		float pos = phase * SIZE;
+		int i = std::min((int)pos, SIZE - 1);
+		float frac = pos - i;
+		const float* b = &data[(level * 2) * STRIDE + i];
+		const float* h = &data[(level * 2 + 1) * STRIDE + i];
+		float baseValue = b[0] + (b[1] - b[0]) * frac;
+		float harmonicValue = h[0] + (h[1] - h[0]) * frac;
+		return baseValue + (harmonicValue - baseValue) * strength;
+	}
+};
 
 struct BasicOscillator : Module {
 	enum ParamId {
@@ -20,6 +115,8 @@ struct BasicOscillator : Module {
 	enum OutputId {
 		LEFT_OUTPUT,
 		RIGHT_OUTPUT,
+		LEFT_SUM_OUTPUT,
+		RIGHT_SUM_OUTPUT,
 		OUTPUTS_LEN
 	};
 	enum LightId {
@@ -37,9 +134,33 @@ struct BasicOscillator : Module {
 		WAVEFORM_SAW = 3
 	};
 
-	float phaseL = 0.f;
-	float phaseR = 0.f;
+	// Polyphony follows the FM input. Each vector holds two channels as
+	// (left, right, left, right) lanes, so a binaural pair never splits across vectors.
+	static constexpr int MAX_CHANNELS = 16;
+	static constexpr int MAX_VECTORS = MAX_CHANNELS / 2;
+	simd::float_4 phase[MAX_VECTORS];
 	float lastClock = 0.f;
+	// Hard sync resets are not periodic, so their jumps go through a minBLEP
+	dsp::MinBlepGenerator<16, 16, simd::float_4> syncBlep[MAX_VECTORS];
+
+	// Band-limited tables: rendered on a worker thread owned by the module (so they
+	// are built headless too), swapped in by the audio thread. The audio thread never
+	// allocates; it only wakes the worker once per table set it is missing.
+	enum TableState {
+		TABLE_IDLE,
+		TABLE_BUILDING,
+		TABLE_READY
+	};
+	std::unique_ptr<BandLimitedTables> tables;
+	std::unique_ptr<BandLimitedTables> pendingTables;
+	std::atomic<int> tableState{TABLE_IDLE};
+	std::atomic<int> requestedTableKey{-1};
+	std::atomic<int> activeTableKey{-1};
+	int wokenTableKey = -1; // audio thread only
+	std::mutex tableMutex;
+	std::condition_variable tableWake;
+	bool tableQuit = false;
+	std::thread tableThread;
 
 	BasicOscillator() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -52,95 +173,144 @@ struct BasicOscillator : Module {
 		configParam(HARMONIC_COUNT_PARAM, 0.f, 16.f, 0.f, "Harmonic Count");
 		configParam(HARMONIC_STRENGTH_PARAM, 0.f, 1.f, 0.f, "Harmonic Strength");
 		configInput(CLOCK_SYNC_INPUT, "Reset");
-		configInput(FM_INPUT, "FM");
-		configOutput(LEFT_OUTPUT, "Left");
-		configOutput(RIGHT_OUTPUT, "Right");
+		configInput(FM_INPUT, "FM (polyphonic 1V/oct)");
+		configOutput(LEFT_OUTPUT, "Left (polyphonic)");
+		configOutput(RIGHT_OUTPUT, "Right (polyphonic)");
+		configOutput(LEFT_SUM_OUTPUT, "Left sum");
+		configOutput(RIGHT_SUM_OUTPUT, "Right sum");
+		
+		for (int v = 0; v < MAX_VECTORS; v++)
+			phase[v] = 0.f;
 		
 		// Set default: Sine button pressed
 		params[WAVEFORM_SINE_BUTTON_PARAM].setValue(1.f);
+
+		tableThread = std::thread([this]() { tableWorker(); });
 	}
 
-	float generateWaveform(WaveformType type, float phase, int harmonicCount, float harmonicStrength) {
-		float signal = 0.f;
-		
-		// Generate base waveform
+	~BasicOscillator() {
+		{
+			std::lock_guard<std::mutex> lock(tableMutex);
+			tableQuit = true;
+		}
+		tableWake.notify_one();
+		if (tableThread.joinable())
+			tableThread.join();
+	}
+
+	static int tableKey(WaveformType type, int harmonicCount) {
+		return (int)type * 32 + harmonicCount;
+	}
+
+	// The requested table set differs from the active one and nothing is being built
+	bool tablesWanted() {
+		int key = requestedTableKey.load();
+		return key >= 0 && key != activeTableKey.load() && tableState.load() == TABLE_IDLE;
+	}
+
+	// Worker thread: sleeps until the audio thread asks for a table set, then renders it
+	void tableWorker() {
+		std::unique_lock<std::mutex> lock(tableMutex);
+		while (true) {
+			tableWake.wait(lock, [this]() { return tableQuit || tablesWanted(); });
+			if (tableQuit)
+				return;
+			int key = requestedTableKey.load();
+			tableState.store(TABLE_BUILDING);
+			lock.unlock();
+			if (!pendingTables)
+				pendingTables.reset(new BandLimitedTables);
+			pendingTables->render(key / 32, key % 32, key);
+			tableState.store(TABLE_READY);
+			lock.lock();
+		}
+	}
+
+	// PolyBLEP single-cycle shape at `phase` with increment `dt`, both channels at once
+	static simd::float_4 polyBlepShape(WaveformType type, simd::float_4 phase, simd::float_4 dt) {
 		switch (type) {
-			case WAVEFORM_SINE:
-				signal = std::sin(2.f * M_PI * phase);
-				break;
-			
 			case WAVEFORM_SQUARE:
-				signal = (phase < 0.5f) ? 1.f : -1.f;
-				break;
+				return BandLimited::square(phase, dt);
 			
-			case WAVEFORM_TRI: {
+			case WAVEFORM_TRI:
 				// Triangle wave: goes from -1 to 1 linearly, then back to -1
-				if (phase < 0.5f) {
-					signal = 4.f * phase - 1.f; // -1 to 1
-				} else {
-					signal = 3.f - 4.f * phase; // 1 to -1
-				}
-				break;
-			}
+				return BandLimited::triangle(phase, dt);
 			
 			case WAVEFORM_SAW:
-				signal = 2.f * phase - 1.f;
-				break;
+				return BandLimited::saw(phase, dt);
 			
 			default:
-				signal = std::sin(2.f * M_PI * phase);
+				return FastMath::sin2pi(phase);
+		}
+	}
+
+	// Processes the four lanes of `phase` and `freq` (two left/right pairs) in one pass
+	simd::float_4 generateWaveform(WaveformType type, simd::float_4 phase, simd::float_4 freq, int harmonicCount, float harmonicStrength, float sampleRate) {
+		bool addHarmonics = harmonicCount > 0 && harmonicStrength > 0.f;
+		
+		if (type == WAVEFORM_SINE) {
+			simd::float_4 signal = FastMath::sin2pi(phase);
+			if (!addHarmonics)
+				return signal;
+			
+			// Harmonics by the Chebyshev recurrence sin((n+1)x) = 2cos(x)sin(nx) - sin((n-1)x):
+			// one multiply-add per partial instead of a sin() call.
+			// Error grows roughly with n^2 * float epsilon and stays below 1e-5 at n = 17.
+			simd::float_4 twoCos = 2.f * FastMath::cos2pi(phase);
+			simd::float_4 prev = 0.f;
+			simd::float_4 cur = signal;
+			simd::float_4 harmonicSum = 0.f;
+			float totalAmplitude = 0.f;
+			// Partials above Nyquist are skipped but still count towards the normalization
+			float topFreq = std::max(std::max(std::fabs(freq[0]), std::fabs(freq[1])), std::max(std::fabs(freq[2]), std::fabs(freq[3])));
+			int audible = topFreq > 0.f ? (int)(0.5f * sampleRate / topFreq) - 1 : harmonicCount;
+			for (int h = 1; h <= harmonicCount; h++) {
+				float amplitude = 1.f / (h + 1);
+				totalAmplitude += amplitude;
+				if (h > audible)
+					continue;
+				simd::float_4 next = twoCos * cur - prev;
+				prev = cur;
+				cur = next;
+				// Amplitude decreases with harmonic number (1/n), h+1 because h=1 is 2nd harmonic
+				harmonicSum += cur * amplitude;
+			}
+			harmonicSum /= totalAmplitude;
+			return signal * (1.f - harmonicStrength) + harmonicSum * harmonicStrength;
+		}
+		
+		// Band-limited table read once the matching table set is active
+		if (tables && tables->key == tableKey(type, harmonicCount)) {
+			float strength = harmonicCount > 0 ? harmonicStrength : 0.f;
+			simd::float_4 level = BandLimitedTables::levelsFor(freq, sampleRate);
+			simd::float_4 signal = 0.f;
+			for (int c = 0; c < 4; c++)
+				signal[c] = tables->read((int)level[c], phase[c], strength);
+			return signal;
 		}
 		
+		// PolyBLEP fallback until the table is rendered
+		simd::float_4 dt = freq / sampleRate;
+		simd::float_4 signal = polyBlepShape(type, phase, dt);
+		
 		// Add harmonics if enabled
-		if (harmonicCount > 0 && harmonicStrength > 0.f) {
-			float harmonicSum = 0.f;
+		if (addHarmonics) {
+			simd::float_4 harmonicSum = 0.f;
 			float totalAmplitude = 0.f;
 			
-			// Add harmonics: 2nd, 3rd, 4th, etc.
+			// Add harmonics: 2nd, 3rd, 4th, etc. using the same waveform type
 			for (int h = 1; h <= harmonicCount; h++) {
-				float harmonicPhase = phase * (h + 1); // h+1 because h=1 is 2nd harmonic
-				harmonicPhase -= std::floor(harmonicPhase); // Wrap to [0, 1)
-				
-				// Generate harmonic using same waveform type
-				float harmonicValue = 0.f;
-				switch (type) {
-					case WAVEFORM_SINE:
-						harmonicValue = std::sin(2.f * M_PI * harmonicPhase);
-						break;
-					
-					case WAVEFORM_SQUARE:
-						harmonicValue = (harmonicPhase < 0.5f) ? 1.f : -1.f;
-						break;
-					
-					case WAVEFORM_TRI: {
-						if (harmonicPhase < 0.5f) {
-							harmonicValue = 4.f * harmonicPhase - 1.f;
-						} else {
-							harmonicValue = 3.f - 4.f * harmonicPhase;
-						}
-						break;
-					}
-					
-					case WAVEFORM_SAW:
-						harmonicValue = 2.f * harmonicPhase - 1.f;
-						break;
-					
-					default:
-						harmonicValue = std::sin(2.f * M_PI * harmonicPhase);
-				}
+				simd::float_4 harmonicPhase = phase * (float)(h + 1); // h+1 because h=1 is 2nd harmonic
+				harmonicPhase -= simd::floor(harmonicPhase); // Wrap to [0, 1)
 				
 				// Amplitude decreases with harmonic number (1/n)
 				float amplitude = 1.f / (h + 1);
-				harmonicSum += harmonicValue * amplitude;
+				harmonicSum += polyBlepShape(type, harmonicPhase, dt * (float)(h + 1)) * amplitude;
 				totalAmplitude += amplitude;
 			}
 			
 			// Normalize and mix harmonics with base signal
-			if (totalAmplitude > 0.f) {
-				harmonicSum /= totalAmplitude;
-			}
-			
-			// Mix base signal with harmonics
+			harmonicSum /= totalAmplitude;
 			signal = signal * (1.f - harmonicStrength) + harmonicSum * harmonicStrength;
 		}
 		
@@ -148,48 +318,34 @@ struct BasicOscillator : Module {
 	}
 
 	void process(const ProcessArgs& args) override {
+		// One voice per FM channel; without a cable the knob plays a single voice
+		bool fmConnected = inputs[FM_INPUT].isConnected();
+		int channels = std::max(1, inputs[FM_INPUT].getChannels());
+		int vectors = (channels + 1) / 2;
+		
 		// Get the carrier frequency from the knob
 		float pitch = params[FREQ_PARAM].getValue();
-
-		// Add FM input if connected (typically 1V/Oct scaling)
-		float fm = 0.f;
-		if (inputs[FM_INPUT].isConnected()) {
-			fm = inputs[FM_INPUT].getVoltage() * 12.f;
-		}
-		pitch += fm;
-
-		// Convert pitch to carrier frequency
-		float carrierFreq = dsp::FREQ_C4 * std::pow(2.f, pitch / 12.f);
 		
 		// Get beat frequency
 		float beatFreq = params[BEAT_FREQ_PARAM].getValue();
 		
-		// Calculate left and right channel frequencies for binaural beats
-		// Left: carrier + beat/2, Right: carrier - beat/2
-		float freqL = carrierFreq + beatFreq * 0.5f;
-		float freqR = carrierFreq - beatFreq * 0.5f;
+		// Left: carrier + beat/2, Right: carrier - beat/2, for each channel of the pair
+		simd::float_4 beatOffset(beatFreq * 0.5f, -beatFreq * 0.5f, beatFreq * 0.5f, -beatFreq * 0.5f);
 
 		// Clock sync: detect rising edge and reset phase
+		bool syncReset = false;
+		float syncOffset = 0.f;
 		if (inputs[CLOCK_SYNC_INPUT].isConnected()) {
 			float clock = inputs[CLOCK_SYNC_INPUT].getVoltage();
 			if (clock > 1.f && lastClock <= 1.f) {
-				// Rising edge detected, reset phases
-				phaseL = 0.f;
-				phaseR = 0.f;
+				// Rising edge detected: phases are reset below, at the sub-sample
+				// position of the 1V crossing, in (-1, 0] relative to this sample
+				syncReset = true;
+				syncOffset = clamp((1.f - lastClock) / (clock - lastClock), 1e-6f, 1.f) - 1.f;
 			}
 			lastClock = clock;
 		}
 
-		// Accumulate phases for both channels
-		phaseL += freqL * args.sampleTime;
-		phaseR += freqR * args.sampleTime;
-		
-		// Wrap phases
-		if (phaseL >= 1.f) phaseL -= 1.f;
-		if (phaseR >= 1.f) phaseR -= 1.f;
-		if (phaseL < 0.f) phaseL += 1.f;
-		if (phaseR < 0.f) phaseR += 1.f;
-
 		// Get waveform type from buttons (exclusive selection)
 		// Check which button is pressed (latch buttons stay high when pressed)
 		WaveformType waveformType = WAVEFORM_SINE; // default
@@ -207,19 +363,91 @@ struct BasicOscillator : Module {
 		int harmonicCount = (int)std::round(params[HARMONIC_COUNT_PARAM].getValue());
 		float harmonicStrength = params[HARMONIC_STRENGTH_PARAM].getValue();
 
-		// Generate waveforms for both channels
-		float leftSignal = generateWaveform(waveformType, phaseL, harmonicCount, harmonicStrength);
-		float rightSignal = generateWaveform(waveformType, phaseR, harmonicCount, harmonicStrength);
+		// Band-limited tables for the non-sine modes: request a rebuild when the shape or
+		// harmonic count changes, pick up a finished one
+		if (waveformType != WAVEFORM_SINE)
+			requestedTableKey.store(tableKey(waveformType, harmonicCount));
+		if (tableState.load() == TABLE_READY) {
+			std::swap(tables, pendingTables);
+			activeTableKey.store(tables->key);
+			tableState.store(TABLE_IDLE);
+			wokenTableKey = -1;
+		}
+		int requestedKey = requestedTableKey.load();
+		if (requestedKey != wokenTableKey && tablesWanted()) {
+			wokenTableKey = requestedKey;
+			// Taking the (uncontended) lock orders this wake after the worker's last check
+			{
+				std::lock_guard<std::mutex> lock(tableMutex);
+			}
+			tableWake.notify_one();
+		}
+
+		outputs[LEFT_OUTPUT].setChannels(channels);
+		outputs[RIGHT_OUTPUT].setChannels(channels);
+		float sumL = 0.f;
+		float sumR = 0.f;
+		
+		for (int v = 0; v < vectors; v++) {
+			int c0 = 2 * v;
+			bool pair = c0 + 1 < channels;
+			
+			// Add FM input if connected (typically 1V/Oct scaling), per channel
+			float pitch0 = pitch;
+			float pitch1 = pitch;
+			if (fmConnected) {
+				pitch0 += inputs[FM_INPUT].getVoltage(c0) * 12.f;
+				pitch1 = pair ? pitch + inputs[FM_INPUT].getVoltage(c0 + 1) * 12.f : pitch0;
+			}
+			
+			// Convert pitch to carrier frequency, both channels in one call
+			simd::float_4 carrierFreq = dsp::FREQ_C4 * FastMath::exp2(simd::float_4(pitch0, pitch0, pitch1, pitch1) / 12.f);
+			simd::float_4 freq = carrierFreq + beatOffset;
+			if (!pair) {
+				// Odd channel count: the last vector's upper lanes stay silent
+				freq[2] = 0.f;
+				freq[3] = 0.f;
+			}
+
+			// Accumulate and wrap phases
+			phase[v] += freq * args.sampleTime;
+			phase[v] -= simd::floor(phase[v]);
+
+			// Generate waveforms for both channels of the pair
+			simd::float_4 signal = generateWaveform(waveformType, phase[v], freq, harmonicCount, harmonicStrength, args.sampleRate);
+			if (syncReset) {
+				// Restart from the crossing and hand the jump to the minBLEP
+				simd::float_4 resetPhase = BandLimited::wrap(freq * (args.sampleTime * -syncOffset));
+				simd::float_4 resetSignal = generateWaveform(waveformType, resetPhase, freq, harmonicCount, harmonicStrength, args.sampleRate);
+				syncBlep[v].insertDiscontinuity(syncOffset, resetSignal - signal);
+				phase[v] = resetPhase;
+				signal = resetSignal;
+			}
+			signal += syncBlep[v].process();
+
+			// Output 5V signals (bipolar -5V to +5V)
+			outputs[LEFT_OUTPUT].setVoltage(5.f * signal[0], c0);
+			outputs[RIGHT_OUTPUT].setVoltage(5.f * signal[1], c0);
+			sumL += signal[0];
+			sumR += signal[1];
+			if (pair) {
+				outputs[LEFT_OUTPUT].setVoltage(5.f * signal[2], c0 + 1);
+				outputs[RIGHT_OUTPUT].setVoltage(5.f * signal[3], c0 + 1);
+				sumL += signal[2];
+				sumR += signal[3];
+			}
+		}
+
+		// Stereo mix of all voices, scaled by 1/sqrt(N) so a chord keeps roughly the level of one voice
+		float mixGain = 5.f / std::sqrt((float)channels);
+		outputs[LEFT_SUM_OUTPUT].setVoltage(mixGain * sumL);
+		outputs[RIGHT_SUM_OUTPUT].setVoltage(mixGain * sumR);
 
 		// Update lights based on selected waveform button
 		lights[WAVEFORM_SINE_LIGHT].setBrightness(params[WAVEFORM_SINE_BUTTON_PARAM].getValue() > 0.5f ? 1.f : 0.f);
 		lights[WAVEFORM_SQUARE_LIGHT].setBrightness(params[WAVEFORM_SQUARE_BUTTON_PARAM].getValue() > 0.5f ? 1.f : 0.f);
 		lights[WAVEFORM_TRI_LIGHT].setBrightness(params[WAVEFORM_TRI_BUTTON_PARAM].getValue() > 0.5f ? 1.f : 0.f);
 		lights[WAVEFORM_SAW_LIGHT].setBrightness(params[WAVEFORM_SAW_BUTTON_PARAM].getValue() > 0.5f ? 1.f : 0.f);
-
-		// Output 5V signals (bipolar -5V to +5V)
-		outputs[LEFT_OUTPUT].setVoltage(5.f * leftSignal);
-		outputs[RIGHT_OUTPUT].setVoltage(5.f * rightSignal);
 	}
 };
 
@@ -255,6 +483,7 @@ struct WaveformButton : app::SvgSwitch {
 };
 
 struct BasicOscillatorWidget : ModuleWidget {
+
 	BasicOscillatorWidget(BasicOscillator* module) {
 		setModule(module);
 		setPanel(createPanel(asset::plugin(pluginInstance, "res/BasicOscillator.svg")));
@@ -305,6 +534,10 @@ struct BasicOscillatorWidget : ModuleWidget {
 		float outputY = 115.0f;
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(centerX - portHorizontalSpacing / 2.0f, outputY)), module, BasicOscillator::LEFT_OUTPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(centerX + portHorizontalSpacing / 2.0f, outputY)), module, BasicOscillator::RIGHT_OUTPUT));
+
+		// Summed stereo outputs beside the Harmonic Strength knob
+		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(5.0, 86.0)), module, BasicOscillator::LEFT_SUM_OUTPUT));
+		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(25.48, 86.0)), module, BasicOscillator::RIGHT_SUM_OUTPUT));
 	}
 };
 
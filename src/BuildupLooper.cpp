@@ -3,25 +3,63 @@
  *
  * 使用说明 (Usage):
  * - 连接：AUDIO IN L/R 接音源，AUDIO OUT L/R 接下游。TRIG/GATE 可选，用于按住触发。
+ *   AUDIO IN 支持复音（最多 16 通道），所有通道共用同一个 loop 与播放头，输出通道数与输入相同。
  * - 触发：点击 BUILD 按钮进入 build（再点退出），或 TRIG 输入高电平进入、低电平退出。
  * - INTENSITY：循环加速到的最大倍率 (1x~15x)；可接 CV（0–10V=1–15x），如 LFO 由外部控制速度。
  * - TIME：从 1x 加速到最大倍率所需时间 (2~16s)。
  * - LOOP：截取的片段长度 (1/16秒~2秒)，决定 loop 内容多长。
  * - CLOCK：若接入时钟，loop 长度按小节选择（1/2/4/8 bar），由 BAR 旋钮选择；无时钟时仍用 LOOP 旋钮（秒）。
+ * - MODE：Accelerate（加速）/ Stutter（反复播放 loop 开头，切片长度逐级减半）/ Ratchet（按拍前进，每拍开头按切片长度重复）。
+ *   Stutter/Ratchet 下切片长度在 TIME 内从 1 loop 减半到 1/64，INTENSITY 决定最多减半几级；有时钟时只在预测的拍点切换。
+ * - SLICE：切片正放 / 反放 / 交替；GATE：切片门控图案（按切片序号循环 8 步，静音的切片输出为 0）。
+ * - EXPORT：触发输入或右键菜单 "Export loop to WAV"，把当前 loop（未在 build 时为最近 LOOP 长度）写入补丁存储目录
+ *   loop-NNN.wav（32-bit float，每通道 L/R 相邻）；菜单 "Export with acceleration curve" 则导出按 TIME/INTENSITY 加速的整段。
  */
 
 #include "plugin.hpp"
+#include "ClockTransport.hpp"
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 
 namespace BuildupLooper {
 
-// 最大采样率下 2.5s 的样本数，用于环形缓冲（ring buffer）
-static constexpr int RING_MAX_SAMPLES = (int)(2.5f * 192000.f);
-// 最大 loop 长度 2s @ 192k
-static constexpr int LOOP_MAX_SAMPLES = (int)(2.f * 192000.f);
+// 环形缓冲（ring buffer）时长 (s)，按实际采样率分配
+static constexpr float RING_SECONDS = 2.5f;
+// 最大 loop 长度 (s)
+static constexpr float LOOP_MAX_SECONDS = 2.f;
+// 最短 loop 长度 (s)：两个环中连续写入的新数据都不足 L 时，截取缩短到可用长度，但不短于此值
+static constexpr float LOOP_MIN_SECONDS = 1.f / 16.f;
 // 退出 build 时的 crossfade 时长 (ms)
 static constexpr float EXIT_FADE_MS = 20.f;
 // Loop 接缝处 crossfade 时长 (ms)，避免爆音
 static constexpr float LOOP_FADE_MS = 10.f;
+// mip 层数（含原始层）：第 k 层为 2^k 倍抽取，4 层抽取覆盖 15x 加速
+static constexpr int MIP_LEVELS = 5;
+// 所有 mip 层在 loop 开始播放后的这段时间内分摊计算完成 (ms)
+static constexpr float MIP_BUILD_MS = 250.f;
+// 层长度低于此值时不再继续抽取
+static constexpr int MIP_MIN_LEN = 64;
+// 从原始层过渡到第 1 层的倍率范围上限（见 readMip）
+static constexpr float MIP_ENTRY_RATE = 1.0625f;
+// Stutter/Ratchet 切片级数：1, 1/2, 1/4 ... 1/64 loop
+static constexpr int SLICE_STAGES = 7;
+// 切片边界的淡入淡出时长 (ms)，切片很短时按切片长度缩短
+static constexpr float SLICE_FADE_MS = 2.f;
+// 切片门控图案：第 i 位为 1 表示第 i 个切片（按 8 循环）发声
+static constexpr int GATE_PATTERN_COUNT = 6;
+static const uint8_t GATE_PATTERNS[GATE_PATTERN_COUNT] = {
+	0xFF,  // x x x x x x x x
+	0x55,  // x . x . x . x .
+	0x6D,  // x . x x . x x .
+	0x49,  // x . . x . . x .
+	0x77,  // x x x . x x x .
+	0xDD,  // x . x x x . x x
+};
 
 // Ease-in-out: progress in [0,1] -> smooth curve (techno build-up feel)
 static inline float easeInOut(float x) {
@@ -29,16 +67,193 @@ static inline float easeInOut(float x) {
 	return x * x * (3.f - 2.f * x);
 }
 
-// 线性插值从 buffer 读取（避免锯齿，不分配内存）
-static inline float readLinear(const float* buf, int size, float pos) {
-	if (size <= 0) return 0.f;
-	while (pos < 0.f) pos += size;
-	while (pos >= size) pos -= size;
-	int i0 = (int)pos;
-	int i1 = i0 + 1;
-	if (i1 >= size) i1 = 0;
-	float f = pos - (float)i0;
-	return buf[i0] * (1.f - f) + buf[i1] * f;
+// 31 阶半带 FIR（Blackman 窗 sinc，截止 fs/4）；除中心外偶数偏移系数为 0，只保存奇数偏移
+struct HalfBandKernel {
+	static constexpr int HALF = 15;
+	float center = 0.5f;
+	float odd[(HALF + 1) / 2];  // odd[i] 对应偏移 ±(2i + 1)
+
+	HalfBandKernel() {
+		float sum = center;
+		for (int i = 0; i < (HALF + 1) / 2; i++) {
+			int n = 2 * i + 1;
+			float x = (float)n * 0.5f;
+			float sinc = std::sin((float)M_PI * x) / ((float)M_PI * x);
+			float w = (float)(n + HALF + 1) / (float)(2 * HALF + 2);
+			float window = 0.42f - 0.5f * std::cos(2.f * (float)M_PI * w) + 0.08f * std::cos(4.f * (float)M_PI * w);
+			odd[i] = 0.5f * sinc * window;
+			sum += 2.f * odd[i];
+		}
+		// 直流增益归一
+		center /= sum;
+		for (int i = 0; i < (HALF + 1) / 2; i++)
+			odd[i] /= sum;
+	}
+
+	static const HalfBandKernel& get() {
+		static HalfBandKernel instance;
+		return instance;
+	}
+};
+
+// 每帧最多 MAX_FRAME_WIDTH 个 float_4：16 通道 L + 16 通道 R
+static constexpr int MAX_CHANNELS = 16;
+static constexpr int MAX_FRAME_WIDTH = MAX_CHANNELS * 2 / 4;
+
+// 每层 loop 末尾之后保留的保护样本（= 开头样本的副本），插值读取 i0 + 1 时无需回绕判断
+static constexpr int LOOP_GUARD = 1;
+// loop 最短样本数：大于最大倍率 15x 与 LOOP_GUARD，播放头每样本前进不到一个 loop，一次条件减法即可回绕
+// （CLOCK 接入很快的时钟时 bars * 4 * 拍长可能只有几个样本）
+static constexpr int LOOP_MIN_SAMPLES = 16;
+// 播放头定点格式：高 32 位为样本索引，低 32 位为小数
+static constexpr int PLAYHEAD_FRAC_BITS = 32;
+static constexpr double PLAYHEAD_ONE = 4294967296.0;
+
+// loop 的一层：第 i 帧为 buf[((start + i) & mask) * width] 起的 width 个 float_4，i ∈ [0, len + LOOP_GUARD)
+// 帧内交错存放：前 2 * width 个 float 为各通道 L，后 2 * width 个为各通道 R
+// 原始层引用冻结环（2 的幂长度），mip 层为线性缓冲（mask 全 1，start 0）
+struct LoopView {
+	const simd::float_4* buf = nullptr;
+	int width = 1;
+	uint32_t mask = 0xFFFFFFFFu;
+	uint32_t start = 0;
+	int len = 0;
+
+	// 周期读取（用于 mip 计算）：idx 可以超出 [0, len) 至多一个周期
+	const simd::float_4* frame(int idx) const {
+		if (idx < 0) idx += len;
+		else if (idx >= len) idx -= len;
+		return &buf[((start + (uint32_t)idx) & mask) * (uint32_t)width];
+	}
+
+	// 读取位置 p ∈ [0, len) 的整帧到 out[0, width)
+	// 插值系数与结尾 Nfade 个样本和开头的 crossfade 只算一次，所有通道共用
+	void read(float p, int Nfade, simd::float_4* out) const {
+		int i0 = (int)p;
+		float f = p - (float)i0;
+		float fadeStart = (float)(len - Nfade);
+		bool inFade = Nfade > 0 && len >= 2 * Nfade && p >= fadeStart;
+		uint32_t a = (start + (uint32_t)i0) & mask;
+		const simd::float_4* x0 = &buf[a * (uint32_t)width];
+		const simd::float_4* x1 = &buf[((a + 1) & mask) * (uint32_t)width];
+		for (int k = 0; k < width; k++)
+			out[k] = x0[k] + (x1[k] - x0[k]) * f;
+		if (!inFade)
+			return;
+		float q = p - fadeStart;
+		int j0 = (int)q;
+		float g = q - (float)j0;
+		float w = q / (float)Nfade;
+		uint32_t c = (start + (uint32_t)j0) & mask;
+		const simd::float_4* y0 = &buf[c * (uint32_t)width];
+		const simd::float_4* y1 = &buf[((c + 1) & mask) * (uint32_t)width];
+		for (int k = 0; k < width; k++) {
+			simd::float_4 y = y0[k] + (y1[k] - y0[k]) * g;
+			out[k] += (y - out[k]) * w;
+		}
+	}
+};
+
+// 下一层第 i 帧 = 本层在 2i 处半带滤波的输出（周期边界）
+static void decimateFrame(const LoopView& src, int i, simd::float_4* y) {
+	const HalfBandKernel& hb = HalfBandKernel::get();
+	int c = 2 * i;
+	const simd::float_4* x = src.frame(c);
+	for (int k = 0; k < src.width; k++)
+		y[k] = hb.center * x[k];
+	for (int j = 0; j < (HalfBandKernel::HALF + 1) / 2; j++) {
+		int n = 2 * j + 1;
+		const simd::float_4* xm = src.frame(c - n);
+		const simd::float_4* xp = src.frame(c + n);
+		for (int k = 0; k < src.width; k++)
+			y[k] += hb.odd[j] * (xm[k] + xp[k]);
+	}
+}
+
+// 读取 mip 第 level 层：播放头以原始层样本计，按层长度等比例映射；接缝 crossfade 长度同样缩放
+static void readMipLevel(const LoopView& v, int level, int len0, uint64_t playhead, int Nfade, simd::float_4* out) {
+	if (v.len <= 0) {
+		for (int k = 0; k < v.width; k++)
+			out[k] = 0.f;
+		return;
+	}
+	float pos;
+	if (level == 0) {
+		pos = (float)(uint32_t)(playhead >> PLAYHEAD_FRAC_BITS) + (float)(uint32_t)playhead * (float)(1.0 / PLAYHEAD_ONE);
+	} else {
+		pos = (float)((double)playhead * (double)v.len / ((double)len0 * PLAYHEAD_ONE));
+		Nfade = std::max(1, Nfade >> level);
+	}
+	// float 舍入可能恰好得到 len
+	if (pos >= (float)v.len) pos -= (float)v.len;
+	v.read(pos, Nfade, out);
+}
+
+// 按播放倍率读取一帧（只使用 levels[0, ready)）
+// 第 k 层只在 rate <= 2^k 时无混叠，因此层 = 1 + log2(rate)：rate ∈ [2^k, 2^(k+1)] 在第 k+1 与 k+2 层之间 crossfade，
+// 两层都不会折叠。1x 时读原始层；1x 到 MIP_ENTRY_RATE 之间线性过渡到第 1 层，
+// 这一段原始层折叠的只有 fs/2 / MIP_ENTRY_RATE 以上的成分（48kHz 下 22.5kHz 以上）
+static void readMip(const LoopView* levels, int ready, uint64_t playhead, int Nfade, float rate, simd::float_4* out) {
+	float levelF = 0.f;
+	if (rate >= MIP_ENTRY_RATE)
+		levelF = 1.f + std::log2(rate);
+	else if (rate > 1.f)
+		levelF = (rate - 1.f) / (MIP_ENTRY_RATE - 1.f) * (1.f + std::log2(MIP_ENTRY_RATE));
+	levelF = std::min(levelF, (float)(ready - 1));
+	int k0 = (int)levelF;
+	float f = levelF - (float)k0;
+	readMipLevel(levels[k0], k0, levels[0].len, playhead, Nfade, out);
+	if (f <= 0.f || k0 + 1 >= ready)
+		return;
+	alignas(16) simd::float_4 v1[MAX_FRAME_WIDTH];
+	readMipLevel(levels[k0 + 1], k0 + 1, levels[0].len, playhead, Nfade, v1);
+	for (int k = 0; k < levels[0].width; k++)
+		out[k] += (v1[k] - out[k]) * f;
+}
+
+// 写 32-bit float WAV（多于 2 通道时用 WAVE_FORMAT_EXTENSIBLE），samples 为交错样本
+static bool writeWavFloat(const std::string& path, const std::vector<float>& samples, int channels, int sampleRate) {
+	bool extensible = channels > 2;
+	uint32_t dataBytes = (uint32_t)(samples.size() * sizeof(float));
+	uint32_t fmtBytes = extensible ? 40 : 16;
+	std::vector<uint8_t> header;
+	auto put = [&](uint32_t v, int bytes) {
+		for (int i = 0; i < bytes; i++)
+			header.push_back((uint8_t)(v >> (8 * i)));
+	};
+	auto tag = [&](const char* t) {
+		header.insert(header.end(), t, t + 4);
+	};
+	tag("RIFF");
+	put(4 + (8 + fmtBytes) + (8 + dataBytes), 4);
+	tag("WAVE");
+	tag("fmt ");
+	put(fmtBytes, 4);
+	put(extensible ? 0xFFFE : 3, 2);
+	put((uint32_t)channels, 2);
+	put((uint32_t)sampleRate, 4);
+	put((uint32_t)(sampleRate * channels * 4), 4);
+	put((uint32_t)(channels * 4), 2);
+	put(32, 2);
+	if (extensible) {
+		put(22, 2);
+		put(32, 2);  // valid bits
+		put(0, 4);   // channel mask：不指定扬声器位置
+		// KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+		static const uint8_t guid[16] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+		header.insert(header.end(), guid, guid + 16);
+	}
+	tag("data");
+	put(dataBytes, 4);
+
+	std::FILE* f = std::fopen(path.c_str(), "wb");
+	if (!f)
+		return false;
+	bool ok = std::fwrite(header.data(), 1, header.size(), f) == header.size();
+	// 样本按小端 float 写出（Rack 支持的平台均为小端）
+	ok = ok && std::fwrite(samples.data(), sizeof(float), samples.size(), f) == samples.size();
+	ok = (std::fclose(f) == 0) && ok;
+	return ok;
 }
 
 struct BuildupLooperModule : Module {
@@ -48,6 +263,9 @@ struct BuildupLooperModule : Module {
 		TIME_PARAM,
 		LOOP_PARAM,
 		BAR_PARAM,  // 1/2/4/8 bar，仅当 CLOCK 接入时有效
+		MODE_PARAM,
+		SLICE_PARAM,
+		PATTERN_PARAM,
 		PARAMS_LEN
 	};
 	enum InputId {
@@ -56,6 +274,7 @@ struct BuildupLooperModule : Module {
 		INTENSITY_INPUT,
 		AUDIO_L_INPUT,
 		AUDIO_R_INPUT,
+		EXPORT_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId {
@@ -68,23 +287,55 @@ struct BuildupLooperModule : Module {
 		LIGHTS_LEN
 	};
 
-	// 环形缓冲：平时持续写入最近 2s+ 的音频；触发时从其中截取最近 L 作为 loop（锁定后不再写入该段）
-	// 延迟分配，避免构造时大块分配导致宿主崩溃
-	float* ringL = nullptr;
-	float* ringR = nullptr;
+	// 双环形缓冲：IDLE 时两个环同时写入最近 2.5s+ 的音频（长度为 2 的幂，按掩码回绕）
+	// 触发时冻结其中一个环，loop 直接引用其中最近 L 个样本（O(1)，无拷贝），另一个环继续写入
+	// 冻结连续写入最久的环：刚解冻的环只有解冻之后的数据是新的，其余是 build 之前的旧音频
+	// ringFresh 记录每个环自上次恢复写入以来连续写入的样本数；不足 L 时缩短截取，仍不足最短 loop 则暂不截取
+	// 按实际采样率在 onSampleRateChange 中分配（引擎此时不会调用 process），process 中从不分配
+	// 每帧 frameWidth 个 float_4（见 LoopView），可容纳 2 * frameWidth 个通道
+	// 代价：纯立体声时每帧 (L0, L1, R0, R1) 只用一半，内存是 2 float 帧的两倍（48kHz 约 5.6MB，192kHz 约 22MB）；
+	// 换来的是所有读取、插值、mip 与 crossfade 都按对齐的 float_4 整帧处理，单声道与多通道共用一条 SIMD 路径
+	std::vector<simd::float_4> ring[2];
+	int frameWidth = 1;
 	int ringSize = 0;
-	int ringWritePos = 0;
+	uint32_t ringMask = 0;
+	uint32_t ringWritePos = 0;
+	int frozenRing = -1;      // 当前被 loop 引用的环，-1 表示没有（IDLE）
+	int ringFresh[2] = {};    // 连续写入的样本数（封顶 ringSize）
+
+	int loopCapacity = 0;     // 最大 loop 长度（样本数）
+	uint32_t loopStart = 0;   // loop 在冻结环中的起点
+	int loopSamples = 0;      // 当前 loop 长度（锁定后不变）
 
-	// 锁定后的 loop 副本（触发瞬间从 ring 拷贝，之后只读）
-	float* loopL = nullptr;
-	float* loopR = nullptr;
-	int loopSamples = 0;  // 当前 loop 长度（锁定后不变）
+	// loop 的 mip 金字塔：第 k 层由第 k-1 层半带滤波后 2 倍抽取（周期边界），按播放倍率选择层并在相邻层间 crossfade
+	// 冻结后在 build 开头的 MIP_BUILD_MS 内逐步计算，尚未完成的层不会被读取
+	std::vector<simd::float_4> mip[MIP_LEVELS];  // [0] 不使用（原始层即冻结环）
+	int mipLen[MIP_LEVELS] = {};
+	int mipLevelCount = 1;    // 本次 loop 需要的层数
+	int mipReadyLevels = 1;   // 已完成的层数（原始层总是可用）
+	int mipBuildIndex = 0;    // 正在计算的层 = mipReadyLevels，已完成的输出样本数
+	int mipBuildBudget = 1;   // 每个 process 计算的输出样本数
+	float currentRate = 1.f;
+	int loopChannels = 1;     // 冻结时的通道数
+
+	// 通道数超过 2 * frameWidth 时扩容：process 只登记需要的帧宽，模块自己的后台线程分配新缓冲（无界面运行时同样扩容），
+	// process 在 IDLE 时 O(1) 交换，换下的旧缓冲再交回后台线程释放。扩容完成前多出的通道直通
+	enum ResizeState { RESIZE_NONE, RESIZE_READY, RESIZE_SWAPPED };
+	std::atomic<int> resizeState{RESIZE_NONE};
+	std::atomic<int> requestedWidth{1};
+	std::atomic<int> allocatedWidth{1};
+	std::vector<simd::float_4> pendingRing[2];
+	std::vector<simd::float_4> pendingMip[MIP_LEVELS];
+	int pendingWidth = 1;
+	float pendingRate = 0.f;
+	std::atomic<float> bufferRate{0.f};
 
 	// Build 状态
 	enum State { IDLE, BUILD, EXIT_FADE };
+	enum Mode { MODE_ACCELERATE, MODE_STUTTER, MODE_RATCHET };
+	enum SliceDirection { SLICE_FORWARD, SLICE_REVERSE, SLICE_ALTERNATE };
 	State state = IDLE;
-	float playheadL = 0.f;   // 当前播放位置 [0, loopSamples)
-	float playheadR = 0.f;
+	uint64_t playhead = 0;   // 左右声道共用的定点播放位置 [0, loopSamples)
 	int rampSamples = 0;     // 已加速的样本数
 	float exitFadeSamples = 0.f;
 	float exitFadeTotal = 1.f;
@@ -98,58 +349,194 @@ struct BuildupLooperModule : Module {
 	float smoothedTime = 8.f;
 	float smoothedLoopSec = 0.25f;
 
+	// 导出：音频线程只记录快照（钉住一个环 + loop 位置）并唤醒模块自己的后台线程处理，
+	// 不依赖 UI（无界面运行 Rack 时 EXPORT 触发同样有效，环不会一直被钉住）
+	// 后台线程先把 loop 拷出再解除钉住，之后的渲染与磁盘 I/O 都与音频线程无关
+	enum ExportState { EXPORT_IDLE, EXPORT_PINNED, EXPORT_RUNNING };
+	struct ExportSnapshot {
+		uint32_t start = 0;
+		int len = 0;
+		int channels = 1;
+		int width = 1;
+		int Nfade = 0;
+		float sampleRate = 48000.f;
+		float intensity = 1.f;
+		float time = 8.f;
+	};
+	std::atomic<int> exportState{EXPORT_IDLE};
+	std::atomic<bool> exportRequested{false};
+	std::atomic<int> exportRing{-1};  // 被导出钉住的环：拷贝完成前音频线程不写入，也不冻结它
+	std::mutex exportCopyMutex;       // 拷贝期间保护环不被 onSampleRateChange 重新分配；同时保护 exportDir
+	ExportSnapshot exportSnapshot;
+	std::string exportDir;            // 补丁存储目录，在 onAdd 中取得（后台线程没有 Rack context）
+	// 后台线程：导出与扩容缓冲的分配/释放都在这里，不依赖 UI；没有任务时阻塞在 workerWake 上
+	std::mutex workerMutex;
+	std::condition_variable workerWake;
+	bool workerQuit = false;          // 受 workerMutex 保护
+	std::thread workerThread;
+	dsp::SchmittTrigger exportTrigger;
+	std::atomic<bool> exportCurve{false};  // 菜单/JSON 写入，后台线程读取
+
 	// Clock：检测上升沿并测量周期（假定每拍一个脉冲，1 bar = 4 拍）
 	bool prevClockHigh = false;
-	int clockSampleCounter = 0;
-	int lastClockSample = 0;
+	int64_t clockSampleCounter = 0;
+	int64_t lastClockSample = 0;
+	int64_t predictedEdgeSample = -1;  // 下一拍的预测位置（整数样本），-1 表示尚未测到
+	int64_t lastSliceEdgeSample = -1;  // 最近一次用于切片对齐的拍点，避免预测拍点与实际拍点重复处理
 	float beatPeriodSamples = 0.f;  // 测得的一拍长度（样本数）
+	// 相邻 MidiClockSync 的走带信息：CLOCK 未接线时直接提供拍长与拍点
+	ClockTransport::Receiver transport;
+
+	// Stutter/Ratchet 切片状态（整数样本）
+	int sliceStage = 0;       // 当前级：切片长度 = loopSamples >> sliceStage
+	int slicePos = 0;         // 在当前切片重复内的位置
+	int sliceRepeat = 0;      // 本级已开始的切片重复次数（用于反放交替与门控图案）
+	int sliceStart = 0;       // 当前切片在 loop 中的起点
+	int64_t sliceTimeline = 0;  // build 开始以来的样本数（Ratchet 按拍前进用）
 
 	BuildupLooperModule() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		configButton(BUILD_PARAM, "BUILD");
 		configParam(INTENSITY_PARAM, 1.f, 15.f, 1.f, "INTENSITY", "x");
 		configParam(TIME_PARAM, 2.f, 16.f, 8.f, "TIME", " s");
 		configParam(LOOP_PARAM, 1.f / 16.f, 2.f, 0.25f, "LOOP", " s");
 		configSwitch(BAR_PARAM, 0.f, 3.f, 0.f, "Bars (with clock)", {"1", "2", "4", "8"});
+		configSwitch(MODE_PARAM, 0.f, 2.f, 0.f, "MODE", {"Accelerate", "Stutter", "Ratchet"});
+		configSwitch(SLICE_PARAM, 0.f, 2.f, 0.f, "SLICE", {"Forward", "Reverse", "Alternate"});
+		configSwitch(PATTERN_PARAM, 0.f, (float)(GATE_PATTERN_COUNT - 1), 0.f, "GATE pattern",
+			{"x x x x x x x x", "x . x . x . x .", "x . x x . x x .", "x . . x . . x .", "x x x . x x x .", "x . x x x . x x"});
 		configInput(TRIG_INPUT, "TRIG/GATE");
 		configInput(CLOCK_INPUT, "CLOCK");
 		configInput(INTENSITY_INPUT, "INTENSITY (0–10V = 1–15x)");
 		configInput(AUDIO_L_INPUT, "AUDIO L");
 		configInput(AUDIO_R_INPUT, "AUDIO R");
+		configInput(EXPORT_INPUT, "EXPORT loop to WAV (trigger)");
 		configOutput(AUDIO_L_OUTPUT, "AUDIO L");
 		configOutput(AUDIO_R_OUTPUT, "AUDIO R");
+		allocateBuffers(APP->engine->getSampleRate());
+		workerThread = std::thread([this]() { backgroundWorker(); });
 	}
 
 	~BuildupLooperModule() {
-		if (ringL) { delete[] ringL; ringL = nullptr; }
-		if (ringR) { delete[] ringR; ringR = nullptr; }
-		if (loopL) { delete[] loopL; loopL = nullptr; }
-		if (loopR) { delete[] loopR; loopR = nullptr; }
-	}
-
-	// 首次 process 时分配缓冲，避免构造时大块分配导致加载插件崩溃
-	void ensureBuffers() {
-		if (ringL) return;
-		ringSize = RING_MAX_SAMPLES;
-		ringL = new float[ringSize];
-		ringR = new float[ringSize];
-		loopL = new float[LOOP_MAX_SAMPLES];
-		loopR = new float[LOOP_MAX_SAMPLES];
-		std::memset(ringL, 0, sizeof(float) * ringSize);
-		std::memset(ringR, 0, sizeof(float) * ringSize);
-		std::memset(loopL, 0, sizeof(float) * LOOP_MAX_SAMPLES);
-		std::memset(loopR, 0, sizeof(float) * LOOP_MAX_SAMPLES);
+		{
+			std::lock_guard<std::mutex> lock(workerMutex);
+			workerQuit = true;
+		}
+		workerWake.notify_one();
+		if (workerThread.joinable())
+			workerThread.join();
+	}
+
+	void onAdd(const AddEvent& e) override {
+		std::lock_guard<std::mutex> lock(exportCopyMutex);
+		exportDir = getPatchStorageDirectory();
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "exportCurve", json_boolean(exportCurve.load()));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* curveJ = json_object_get(rootJ, "exportCurve");
+		if (curveJ)
+			exportCurve.store(json_boolean_value(curveJ));
+	}
+
+	static int ringSizeFor(float sampleRate) {
+		int size = 1;
+		while ((float)size < RING_SECONDS * sampleRate)
+			size <<= 1;
+		return size;
+	}
+
+	static int loopCapacityFor(float sampleRate) {
+		return std::max(LOOP_MIN_SAMPLES, (int)(LOOP_MAX_SECONDS * sampleRate));
+	}
+
+	// 按采样率与帧宽分配环与 mip 层（立体声 48kHz 下约 5.6MB，16 通道时按需扩到约 45MB）
+	static void allocateLayers(float sampleRate, int width, std::vector<simd::float_4> (&rings)[2], std::vector<simd::float_4> (&mips)[MIP_LEVELS]) {
+		int size = ringSizeFor(sampleRate);
+		int capacity = loopCapacityFor(sampleRate);
+		for (int r = 0; r < 2; r++)
+			rings[r].assign((size_t)size * width, 0.f);
+		for (int k = 1; k < MIP_LEVELS; k++)
+			mips[k].assign((size_t)((capacity >> k) + 1 + LOOP_GUARD) * width, 0.f);
+	}
+
+	// 按采样率分配缓冲（而不是按 192kHz 固定分配）
+	// 原有内容与时钟测量在新采样率下无效，一并复位
+	void allocateBuffers(float sampleRate) {
+		// 尚未拷出的导出快照随旧缓冲作废
+		std::lock_guard<std::mutex> lock(exportCopyMutex);
+		exportRing.store(-1);
+		ringSize = ringSizeFor(sampleRate);
+		ringMask = (uint32_t)ringSize - 1;
+		loopCapacity = loopCapacityFor(sampleRate);
+		frameWidth = std::max(frameWidth, requestedWidth.load());
+		allocateLayers(sampleRate, frameWidth, ring, mip);
+		allocatedWidth.store(frameWidth);
+		bufferRate.store(sampleRate);
+		mipLevelCount = 1;
+		mipReadyLevels = 1;
+		ringWritePos = 0;
+		ringFresh[0] = ringFresh[1] = 0;
+		frozenRing = -1;
+		loopStart = 0;
+		loopSamples = 0;
+		state = IDLE;
+		beatPeriodSamples = 0.f;
+		predictedEdgeSample = -1;
+		lastSliceEdgeSample = -1;
+		exitFadeTotal = EXIT_FADE_MS * 0.001f * sampleRate;
 	}
 
 	void onSampleRateChange(const SampleRateChangeEvent& e) override {
-		exitFadeTotal = EXIT_FADE_MS * 0.001f * e.sampleRate;
+		allocateBuffers(e.sampleRate);
+	}
+
+	// 后台线程调用：按 process 登记的帧宽准备扩容缓冲，或释放已被换下的旧缓冲
+	void serviceResize() {
+		int rs = resizeState.load();
+		if (rs == RESIZE_SWAPPED) {
+			for (int r = 0; r < 2; r++)
+				std::vector<simd::float_4>().swap(pendingRing[r]);
+			for (int k = 0; k < MIP_LEVELS; k++)
+				std::vector<simd::float_4>().swap(pendingMip[k]);
+			resizeState.store(RESIZE_NONE);
+		} else if (rs == RESIZE_NONE) {
+			int width = requestedWidth.load();
+			if (width <= allocatedWidth.load())
+				return;
+			pendingWidth = width;
+			pendingRate = bufferRate.load();
+			allocateLayers(pendingRate, pendingWidth, pendingRing, pendingMip);
+			resizeState.store(RESIZE_READY);
+		}
+	}
+
+	// 音频线程：IDLE 时换入后台线程准备好的缓冲（只交换 vector，不分配不释放）
+	void applyResize() {
+		if (resizeState.load() != RESIZE_READY || state != IDLE || exportRing.load() >= 0)
+			return;
+		// 准备期间采样率变了：丢弃，后台线程会按新采样率重新准备
+		if (pendingRate == bufferRate.load() && pendingWidth > frameWidth) {
+			for (int r = 0; r < 2; r++)
+				ring[r].swap(pendingRing[r]);
+			for (int k = 0; k < MIP_LEVELS; k++)
+				mip[k].swap(pendingMip[k]);
+			frameWidth = pendingWidth;
+			allocatedWidth.store(frameWidth);
+			ringFresh[0] = ringFresh[1] = 0;
+		}
+		resizeState.store(RESIZE_SWAPPED);
+		wakeWorker();
 	}
 
 	void process(const ProcessArgs& args) override {
-		ensureBuffers();  // 首次调用时分配，避免加载插件时崩溃
 		float sr = args.sampleRate;
-		if (exitFadeTotal <= 0.f || exitFadeTotal > 96000.f)
-			exitFadeTotal = EXIT_FADE_MS * 0.001f * sr;
 		bool trigConnected = inputs[TRIG_INPUT].isConnected();
 		float trigV = inputs[TRIG_INPUT].getVoltage();
 		bool gateHigh = trigV >= 0.5f;
@@ -178,22 +565,48 @@ struct BuildupLooperModule : Module {
 		smoothedTime += (timeParam - smoothedTime) * smooth;
 		smoothedLoopSec += (loopParam - smoothedLoopSec) * smooth;
 
-		// Loop 长度：有 CLOCK 时按小节（1/2/4/8 bar），否则按 LOOP 旋钮（秒）
+		// Loop 长度：有 CLOCK（或走带）时按小节（1/2/4/8 bar），否则按 LOOP 旋钮（秒）
 		int L_samples;
 		bool clockConnected = inputs[CLOCK_INPUT].isConnected();
+		bool transportSync = transport.process(this, args.frame) && !clockConnected;
+		bool clocked = clockConnected || transportSync;
+		// 本样本是否为拍点：实际上升沿，或按测得周期预测的下一拍（整数样本）先到
+		bool beatEdge = false;
 		if (clockConnected) {
 			float clockV = inputs[CLOCK_INPUT].getVoltage();
 			bool clockHigh = clockV >= 0.5f;
 			if (clockHigh && !prevClockHigh) {
-				int period = clockSampleCounter - lastClockSample;
-				if (period > 0 && period < (int)(sr * 4.f)) {  // 合理范围约 15~240 BPM
+				int64_t period = clockSampleCounter - lastClockSample;
+				if (period > 0 && period < (int64_t)(sr * 4.f)) {  // 合理范围约 15~240 BPM
 					beatPeriodSamples = 0.1f * beatPeriodSamples + 0.9f * (float)period;
 				}
 				lastClockSample = clockSampleCounter;
+				beatEdge = true;
 			}
 			prevClockHigh = clockHigh;
+			if (beatPeriodSamples > 0.f) {
+				beatEdge = beatEdge || clockSampleCounter == predictedEdgeSample;
+				// 预测拍点与稍晚到达的实际上升沿只算一次（间隔不足半拍的视为同一拍）
+				if (beatEdge && lastSliceEdgeSample >= 0 && (float)(clockSampleCounter - lastSliceEdgeSample) < 0.5f * beatPeriodSamples)
+					beatEdge = false;
+				if (beatEdge)
+					lastSliceEdgeSample = clockSampleCounter;
+				int64_t beat = (int64_t)std::lround(beatPeriodSamples);
+				predictedEdgeSample = lastClockSample + beat;
+				if (predictedEdgeSample <= clockSampleCounter)
+					predictedEdgeSample = lastSliceEdgeSample + beat;
+			}
 			clockSampleCounter++;
-
+		} else if (transportSync) {
+			// 走带给出精确拍长，拍点即位置跨过整拍的样本，无需测量与预测
+			if (transport.state.ticksPerSample > 0.0)
+				beatPeriodSamples = (float)(ClockTransport::TICKS_PER_BEAT / transport.state.ticksPerSample);
+			beatEdge = transport.crossed(ClockTransport::TICKS_PER_BEAT);
+			if (beatEdge)
+				lastSliceEdgeSample = clockSampleCounter;
+			clockSampleCounter++;
+		}
+		if (clocked) {
 			int barIndex = (int)(params[BAR_PARAM].getValue() + 0.5f);
 			barIndex = math::clamp(barIndex, 0, 3);
 			int bars = 1 << barIndex;  // 1, 2, 4, 8
@@ -202,44 +615,91 @@ struct BuildupLooperModule : Module {
 				L_samples = (int)((float)(bars * 4) * beatPeriodSamples);
 			else
 				L_samples = (int)(smoothedLoopSec * sr);  // 尚未测到时钟时用 LOOP
-			L_samples = math::clamp(L_samples, 1, ringSize > 0 ? std::min(LOOP_MAX_SAMPLES, ringSize) : LOOP_MAX_SAMPLES);
+			L_samples = math::clamp(L_samples, LOOP_MIN_SAMPLES, std::min(loopCapacity, ringSize));
 		} else {
 			L_samples = (int)(smoothedLoopSec * sr);
-			L_samples = math::clamp(L_samples, 1, LOOP_MAX_SAMPLES);
+			L_samples = math::clamp(L_samples, LOOP_MIN_SAMPLES, loopCapacity);
 		}
 		int Nfade = (int)(LOOP_FADE_MS * 0.001f * sr);
 		Nfade = math::clamp(Nfade, 4, L_samples / 2);
 
+		// 输入：通道数取 L/R 中较多者；单通道线缆按 Rack 惯例复制到所有通道，只接一侧时另一侧相同
 		bool hasL = inputs[AUDIO_L_INPUT].isConnected();
 		bool hasR = inputs[AUDIO_R_INPUT].isConnected();
-		float inL = hasL ? inputs[AUDIO_L_INPUT].getVoltage() / 10.f : 0.f;
-		float inR = hasR ? inputs[AUDIO_R_INPUT].getVoltage() / 10.f : 0.f;
-		if (hasL && !hasR) inR = inL;
-		if (hasR && !hasL) inL = inR;
+		int channels = math::clamp(std::max(inputs[AUDIO_L_INPUT].getChannels(), inputs[AUDIO_R_INPUT].getChannels()), 1, MAX_CHANNELS);
+		int neededWidth = (channels + 1) / 2;
+		if (neededWidth > frameWidth && neededWidth > requestedWidth.load(std::memory_order_relaxed)) {
+			requestedWidth.store(neededWidth, std::memory_order_relaxed);
+			wakeWorker();
+		}
+		applyResize();
+		int ringChannels = std::min(channels, 2 * frameWidth);
 
-		// 平时：始终写入环形缓冲（直通时也写，保证触发时有最近 L 可用）
-		ringL[ringWritePos] = inL;
-		ringR[ringWritePos] = inR;
-		ringWritePos = (ringWritePos + 1) % ringSize;
+		// 输入帧：inFrame[c] 为 L，inFrame[MAX_CHANNELS + c] 为 R（每侧 16 个 float，便于按 4 通道取 float_4）
+		alignas(16) float inFrame[2 * MAX_CHANNELS + 4] = {};
+		for (int c = 0; c < channels; c += 4) {
+			simd::float_4 l = hasL ? inputs[AUDIO_L_INPUT].getPolyVoltageSimd<simd::float_4>(c) / 10.f : 0.f;
+			simd::float_4 r = hasR ? inputs[AUDIO_R_INPUT].getPolyVoltageSimd<simd::float_4>(c) / 10.f : 0.f;
+			if (hasL && !hasR) r = l;
+			if (hasR && !hasL) l = r;
+			l.store(&inFrame[c]);
+			r.store(&inFrame[MAX_CHANNELS + c]);
+		}
+
+		// 平时：始终写入环形缓冲（直通时也写，保证触发时有最近 L 可用）；被 loop 引用的环不写
+		alignas(16) float packed[4 * MAX_FRAME_WIDTH] = {};
+		packFrame(inFrame, ringChannels, packed);
+		int pinnedRing = exportRing.load(std::memory_order_acquire);
+		for (int r = 0; r < 2; r++) {
+			if (r == frozenRing || r == pinnedRing) {
+				ringFresh[r] = 0;
+				continue;
+			}
+			ringFresh[r] = std::min(ringFresh[r] + 1, ringSize);
+			simd::float_4* dst = &ring[r][(size_t)ringWritePos * frameWidth];
+			for (int k = 0; k < frameWidth; k++)
+				dst[k] = simd::float_4::load(&packed[4 * k]);
+		}
+		ringWritePos = (ringWritePos + 1) & ringMask;
+
+		bool exportTrig = exportTrigger.process(inputs[EXPORT_INPUT].getVoltage(), 0.1f, 1.f);
+		if (exportRequested.load(std::memory_order_relaxed))
+			exportTrig = exportRequested.exchange(false) || exportTrig;
+		if (exportTrig && exportState.load() == EXPORT_IDLE)
+			takeExportSnapshot(L_samples, ringChannels, sr);
+
+		outputs[AUDIO_L_OUTPUT].setChannels(channels);
+		outputs[AUDIO_R_OUTPUT].setChannels(channels);
 
 		// ---------- 状态机 ----------
+		int captureRing = freshestRing();
+		int captureLen = std::min(L_samples, ringFresh[captureRing]);
 		if (state == IDLE) {
-			if (wantBuild) {
-				// 进入 build：锁定 loop = 最近 L_samples 从 ring 拷贝到 loopBuffer
-				int start = (ringWritePos - L_samples + ringSize) % ringSize;
-				for (int i = 0; i < L_samples; i++) {
-					int r = (start + i) % ringSize;
-					loopL[i] = ringL[r];
-					loopR[i] = ringR[r];
-				}
+			if (wantBuild && captureLen >= std::min(L_samples, minCaptureSamples(sr))) {
+				// 进入 build：冻结连续写入最久的环，loop = 其中最近 captureLen 个样本（只记录起点，不拷贝）
+				frozenRing = captureRing;
+				L_samples = captureLen;
+				loopStart = (ringWritePos - (uint32_t)L_samples) & ringMask;
 				loopSamples = L_samples;
-				playheadL = 0.f;
-				playheadR = 0.f;
+				loopChannels = ringChannels;
+				startMipBuild(sr);
+				playhead = 0;
+				sliceStage = 0;
+				slicePos = 0;
+				sliceRepeat = 0;
+				sliceStart = 0;
+				sliceTimeline = 0;
+				// 保护区：冻结环中 loop 结尾之后（不属于 loop 的最旧数据）写入开头样本的副本
+				for (int g = 0; g < LOOP_GUARD; g++) {
+					uint32_t src = (loopStart + (uint32_t)g) & ringMask;
+					uint32_t dst = (loopStart + (uint32_t)(loopSamples + g)) & ringMask;
+					for (int k = 0; k < frameWidth; k++)
+						ring[frozenRing][(size_t)dst * frameWidth + k] = ring[frozenRing][(size_t)src * frameWidth + k];
+				}
 				rampSamples = 0;
 				state = BUILD;
 			}
-			outputs[AUDIO_L_OUTPUT].setVoltage(inL * 10.f);
-			outputs[AUDIO_R_OUTPUT].setVoltage(inR * 10.f);
+			writeOutputs(inFrame, channels, 1.f, false);
 			lights[BUILD_LIGHT].setBrightness(0.f);
 			return;
 		}
@@ -254,31 +714,29 @@ struct BuildupLooperModule : Module {
 				rampSamples++;
 				float T_samples = smoothedTime * sr;
 				float progress = T_samples > 0.f ? math::clamp((float)rampSamples / T_samples, 0.f, 1.f) : 1.f;
-				float rate = 1.f + (smoothedIntensity - 1.f) * easeInOut(progress);
-
-				playheadL += rate;
-				playheadR += rate;
-				while (playheadL >= loopSamples) playheadL -= loopSamples;
-				while (playheadR >= loopSamples) playheadR -= loopSamples;
-				while (playheadL < 0.f) playheadL += loopSamples;
-				while (playheadR < 0.f) playheadR += loopSamples;
-
-				// 从 loop 带 crossfade 的读取（接缝处淡入淡出）
-				float outL = readWithLoopCrossfade(loopL, loopSamples, playheadL, Nfade);
-				float outR = readWithLoopCrossfade(loopR, loopSamples, playheadR, Nfade);
-
-				// 可选：build 期间若信号很小则轻微提升增益（soft clip）
-				float gain = 1.f;
-				float peak = std::max(std::fabs(outL), std::fabs(outR));
-				if (peak > 0.001f && peak < 0.2f) gain = 0.25f / peak;
-				gain = math::clamp(gain, 1.f, 3.f);
-				outL *= gain;
-				outR *= gain;
-				outL = math::clamp(outL, -1.2f, 1.2f);
-				outR = math::clamp(outR, -1.2f, 1.2f);
-
-				outputs[AUDIO_L_OUTPUT].setVoltage(outL * 10.f);
-				outputs[AUDIO_R_OUTPUT].setVoltage(outR * 10.f);
+				int mode = (int)(params[MODE_PARAM].getValue() + 0.5f);
+				float sliceGain = 1.f;
+				alignas(16) simd::float_4 out[MAX_FRAME_WIDTH];
+				if (mode == MODE_ACCELERATE) {
+					float rate = 1.f + (smoothedIntensity - 1.f) * easeInOut(progress);
+					currentRate = rate;
+					advanceMipBuild();
+
+					// rate <= 15 < LOOP_MIN_SAMPLES，一次条件减法即可回绕
+					uint64_t loopFixed = (uint64_t)loopSamples << PLAYHEAD_FRAC_BITS;
+					playhead += (uint64_t)((double)rate * PLAYHEAD_ONE);
+					playhead -= (playhead >= loopFixed) ? loopFixed : 0;
+
+					// 从 loop 带 crossfade 的读取（接缝处淡入淡出）
+					readLoop(Nfade, rate, out);
+				} else {
+					currentRate = 1.f;
+					sliceGain = advanceSlice(mode, progress, clocked && beatPeriodSamples > 0.f, beatEdge, sr);
+					readLoop(Nfade, 1.f, out);
+				}
+				alignas(16) float outFrame[2 * MAX_CHANNELS + 4] = {};
+				unpackFrame(out, inFrame, channels, outFrame);
+				writeOutputs(outFrame, channels, sliceGain, true);
 				// BUILD 灯随 progress 变亮
 				lights[BUILD_LIGHT].setBrightness(0.3f + 0.7f * progress);
 				return;
@@ -287,34 +745,339 @@ struct BuildupLooperModule : Module {
 
 		if (state == EXIT_FADE) {
 			float mix = exitFadeTotal > 0.f ? math::clamp(exitFadeSamples / exitFadeTotal, 0.f, 1.f) : 1.f;
-			float loopL_out = readWithLoopCrossfade(loopL, loopSamples, playheadL, Nfade);
-			float loopR_out = readWithLoopCrossfade(loopR, loopSamples, playheadR, Nfade);
-			float outL = loopL_out * (1.f - mix) + inL * mix;
-			float outR = loopR_out * (1.f - mix) + inR * mix;
-			outputs[AUDIO_L_OUTPUT].setVoltage(outL * 10.f);
-			outputs[AUDIO_R_OUTPUT].setVoltage(outR * 10.f);
+			alignas(16) simd::float_4 loopOut[MAX_FRAME_WIDTH];
+			readLoop(Nfade, currentRate, loopOut);
+			alignas(16) float outFrame[2 * MAX_CHANNELS + 4] = {};
+			unpackFrame(loopOut, inFrame, channels, outFrame);
+			for (int c = 0; c < 2 * MAX_CHANNELS; c += 4) {
+				simd::float_4 y = simd::float_4::load(&outFrame[c]);
+				simd::float_4 x = simd::float_4::load(&inFrame[c]);
+				(y + (x - y) * mix).store(&outFrame[c]);
+			}
+			writeOutputs(outFrame, channels, 1.f, false);
 			lights[BUILD_LIGHT].setBrightness(0.3f * (1.f - mix));
 			exitFadeSamples += 1.f;
-			if (exitFadeSamples >= exitFadeTotal)
+			if (exitFadeSamples >= exitFadeTotal) {
 				state = IDLE;
+				frozenRing = -1;
+			}
+		}
+	}
+
+	// 输入帧（每侧 MAX_CHANNELS 个 float）按 frameWidth 压紧为环中的一帧：L 占前 2 * frameWidth 个 float，R 占后 2 * frameWidth 个
+	void packFrame(const float* in, int n, float* packed) const {
+		int side = 2 * frameWidth;
+		for (int c = 0; c < n; c++) {
+			packed[c] = in[c];
+			packed[side + c] = in[MAX_CHANNELS + c];
+		}
+	}
+
+	// 读出的一帧展开回每侧 MAX_CHANNELS 个 float（只写前 n 个通道）；冻结时没有的通道（扩容前多出的通道）直通输入
+	void unpackFrame(const simd::float_4* frame, const float* in, int n, float* out) const {
+		alignas(16) float packed[4 * MAX_FRAME_WIDTH];
+		for (int k = 0; k < frameWidth; k++)
+			frame[k].store(&packed[4 * k]);
+		int side = 2 * frameWidth;
+		int m = std::min(loopChannels, n);
+		for (int c = 0; c < n; c++) {
+			out[c] = c < m ? packed[c] : in[c];
+			out[MAX_CHANNELS + c] = c < m ? packed[side + c] : in[MAX_CHANNELS + c];
+		}
+	}
+
+	// 每 4 个通道一个 float_4 写出；build 时按 L/R 同一通道的峰值做增益提升与限幅（soft clip）
+	void writeOutputs(const float* frame, int n, float sliceGain, bool boost) {
+		for (int c = 0; c < n; c += 4) {
+			simd::float_4 l = simd::float_4::load(&frame[c]);
+			simd::float_4 r = simd::float_4::load(&frame[MAX_CHANNELS + c]);
+			if (boost) {
+				// 若信号很小则轻微提升增益
+				simd::float_4 peak = simd::fmax(simd::fabs(l), simd::fabs(r));
+				simd::float_4 gain = simd::ifelse((peak > 0.001f) & (peak < 0.2f), 0.25f / peak, 1.f);
+				gain = simd::clamp(gain, 1.f, 3.f);
+				l = simd::clamp(l * gain, -1.2f, 1.2f) * sliceGain;
+				r = simd::clamp(r * gain, -1.2f, 1.2f) * sliceGain;
+			}
+			outputs[AUDIO_L_OUTPUT].setVoltageSimd(l * 10.f, c);
+			outputs[AUDIO_R_OUTPUT].setVoltageSimd(r * 10.f, c);
+		}
+	}
+
+	// Stutter/Ratchet：推进一个样本的切片状态并设置 playhead（1x，整数样本），返回切片包络 × 门控
+	// 切片级数只在拍点（有时钟）或切片重复边界（无时钟）增加，因此每次减半都落在拍子网格上
+	float advanceSlice(int mode, float progress, bool clocked, bool beatEdge, float sr) {
+		int maxStage = (int)std::lround((smoothedIntensity - 1.f) / 14.f * (float)(SLICE_STAGES - 1));
+		int targetStage = std::min(maxStage, (int)(easeInOut(progress) * (float)SLICE_STAGES));
+		int sliceLen = std::max(1, loopSamples >> sliceStage);
+		int beatLen = clocked ? std::max(1, (int)std::lround(beatPeriodSamples)) : std::max(1, loopSamples / 4);
+
+		bool boundary = slicePos >= sliceLen;
+		if (boundary) {
+			slicePos = 0;
+			sliceRepeat++;
+		}
+		bool stageChange = sliceStage < targetStage && (clocked ? beatEdge : boundary);
+		if (stageChange) {
+			sliceStage++;
+			sliceLen = std::max(1, loopSamples >> sliceStage);
+			slicePos = 0;
+			sliceRepeat = 0;
+		} else if (beatEdge && sliceLen <= beatLen && slicePos != 0) {
+			// 不超过一拍的切片在每个拍点重新对齐，消除整数舍入与时钟抖动的累积
+			slicePos = 0;
+			sliceRepeat++;
+		}
+
+		// 切片在 loop 中的起点，每次重复开始时确定：Stutter 固定为开头；Ratchet 取当前所在拍的起点，随时间按拍前进
+		if (slicePos == 0)
+			sliceStart = mode == MODE_RATCHET ? (int)(((sliceTimeline / beatLen) * beatLen) % loopSamples) : 0;
+		int direction = (int)(params[SLICE_PARAM].getValue() + 0.5f);
+		bool reverse = direction == SLICE_REVERSE || (direction == SLICE_ALTERNATE && (sliceRepeat & 1));
+		int offset = reverse ? sliceLen - 1 - slicePos : slicePos;
+		int pos = sliceStart + offset;
+		if (pos >= loopSamples) pos -= loopSamples;
+		playhead = (uint64_t)pos << PLAYHEAD_FRAC_BITS;
+
+		// 切片两端淡入淡出，避免跳转处爆音
+		int fade = std::max(1, std::min((int)(SLICE_FADE_MS * 0.001f * sr), sliceLen / 4));
+		float env = std::min(1.f, (float)std::min(slicePos + 1, sliceLen - slicePos) / (float)fade);
+		int pattern = math::clamp((int)(params[PATTERN_PARAM].getValue() + 0.5f), 0, GATE_PATTERN_COUNT - 1);
+		float gate = ((GATE_PATTERNS[pattern] >> (sliceRepeat & 7)) & 1) ? 1.f : 0.f;
+
+		slicePos++;
+		sliceTimeline++;
+		return env * gate;
+	}
+
+	// 未被 loop 引用的环中连续写入最久的一个（被导出钉住的环停止写入，下一样本起 ringFresh 即为 0）
+	int freshestRing() const {
+		int best = -1;
+		for (int r = 0; r < 2; r++) {
+			if (r == frozenRing) continue;
+			if (best < 0 || ringFresh[r] > ringFresh[best])
+				best = r;
+		}
+		return best < 0 ? 0 : best;
+	}
+
+	int minCaptureSamples(float sr) const {
+		return std::max(LOOP_MIN_SAMPLES, (int)(LOOP_MIN_SECONDS * sr));
+	}
+
+	// 第 level 层的视图
+	LoopView levelView(int level) const {
+		LoopView v;
+		v.width = frameWidth;
+		if (level == 0) {
+			v.buf = ring[frozenRing].data();
+			v.mask = ringMask;
+			v.start = loopStart;
+			v.len = loopSamples;
+		} else {
+			v.buf = mip[level].data();
+			v.len = mipLen[level];
+		}
+		return v;
+	}
+
+	// 冻结 loop 后重置 mip 计算：总输出约为 loopSamples（1/2 + 1/4 + ...），在 MIP_BUILD_MS 内分摊
+	void startMipBuild(float sr) {
+		mipLen[0] = loopSamples;
+		mipLevelCount = 1;
+		int total = 0;
+		for (int k = 1; k < MIP_LEVELS; k++) {
+			if (mipLen[k - 1] < MIP_MIN_LEN) break;
+			mipLen[k] = mipLen[k - 1] >> 1;
+			total += mipLen[k];
+			mipLevelCount = k + 1;
+		}
+		mipReadyLevels = 1;
+		mipBuildIndex = 0;
+		float buildSamples = std::max(1.f, MIP_BUILD_MS * 0.001f * sr);
+		// 预算按帧计，每帧的代价随帧宽增长
+		mipBuildBudget = std::max(1, (int)std::ceil((float)total / buildSamples));
+	}
+
+	// 计算 mipBuildBudget 个 mip 输出帧（所有通道）
+	void advanceMipBuild() {
+		int width = frameWidth;
+		for (int b = 0; b < mipBuildBudget && mipReadyLevels < mipLevelCount; b++) {
+			int level = mipReadyLevels;
+			decimateFrame(levelView(level - 1), mipBuildIndex, &mip[level][(size_t)mipBuildIndex * width]);
+			if (++mipBuildIndex >= mipLen[level]) {
+				// 本层完成：写入保护区后才允许读取
+				for (int g = 0; g < LOOP_GUARD; g++) {
+					for (int k = 0; k < width; k++)
+						mip[level][(size_t)(mipLen[level] + g) * width + k] = mip[level][(size_t)g * width + k];
+				}
+				mipReadyLevels++;
+				mipBuildIndex = 0;
+			}
+		}
+	}
+
+	// 按播放倍率读取一帧（只使用已完成的层）
+	void readLoop(int Nfade, float rate, simd::float_4* out) {
+		LoopView levels[MIP_LEVELS];
+		for (int k = 0; k < mipReadyLevels; k++)
+			levels[k] = levelView(k);
+		readMip(levels, mipReadyLevels, playhead, Nfade, rate, out);
+	}
+
+	// 音频线程：钉住 loop 所在的环并发布快照（只写几个字段）；build 中导出当前 loop，否则导出最近 L 个样本
+	void takeExportSnapshot(int L_samples, int ringChannels, float sr) {
+		ExportSnapshot& snap = exportSnapshot;
+		int r;
+		if (frozenRing >= 0) {
+			r = frozenRing;
+			snap.start = loopStart;
+			snap.len = loopSamples;
+			snap.channels = loopChannels;
+		} else {
+			r = freshestRing();
+			snap.len = std::max(LOOP_MIN_SAMPLES, std::min(L_samples, ringFresh[r]));
+			snap.start = (ringWritePos - (uint32_t)snap.len) & ringMask;
+			snap.channels = ringChannels;
+		}
+		snap.width = frameWidth;
+		snap.Nfade = math::clamp((int)(LOOP_FADE_MS * 0.001f * sr), 4, std::max(4, snap.len / 2));
+		snap.sampleRate = sr;
+		snap.intensity = smoothedIntensity;
+		snap.time = smoothedTime;
+		exportRing.store(r, std::memory_order_release);
+		exportState.store(EXPORT_PINNED);
+		wakeWorker();
+	}
+
+	// 后台线程有事可做：导出快照已钉住、换下的旧缓冲待释放，或登记的帧宽尚未分配
+	bool workerHasWork() {
+		int rs = resizeState.load();
+		return exportState.load() == EXPORT_PINNED || rs == RESIZE_SWAPPED
+			|| (rs == RESIZE_NONE && requestedWidth.load() > allocatedWidth.load());
+	}
+
+	// 音频线程只在少数事件上调用（快照、扩容请求、缓冲交换）；先取一次锁，保证唤醒不会落在后台线程检查条件与进入等待之间
+	void wakeWorker() {
+		{
+			std::lock_guard<std::mutex> lock(workerMutex);
+		}
+		workerWake.notify_one();
+	}
+
+	void backgroundWorker() {
+		std::unique_lock<std::mutex> lock(workerMutex);
+		while (true) {
+			workerWake.wait(lock, [this]() { return workerQuit || workerHasWork(); });
+			if (workerQuit)
+				return;
+			lock.unlock();
+			serviceResize();
+			if (exportState.load() == EXPORT_PINNED) {
+				exportState.store(EXPORT_RUNNING);
+				runExport(exportCurve.load());
+				exportState.store(EXPORT_IDLE);
+			}
+			lock.lock();
+		}
+	}
+
+	// 后台线程：拷出 loop 后立即解除钉住，再离线渲染并写 WAV
+	void runExport(bool curve) {
+		ExportSnapshot snap;
+		std::vector<simd::float_4> loop;
+		std::string dir;
+		{
+			std::lock_guard<std::mutex> lock(exportCopyMutex);
+			dir = exportDir;
+			int r = exportRing.load(std::memory_order_acquire);
+			if (r >= 0 && exportSnapshot.len > 0) {
+				snap = exportSnapshot;
+				loop.resize((size_t)(snap.len + LOOP_GUARD) * snap.width);
+				for (int i = 0; i < snap.len + LOOP_GUARD; i++) {
+					uint32_t src = (snap.start + (uint32_t)(i % snap.len)) & ringMask;
+					std::memcpy(&loop[(size_t)i * snap.width], &ring[r][(size_t)src * snap.width], sizeof(simd::float_4) * snap.width);
+				}
+			}
+			exportRing.store(-1, std::memory_order_release);
 		}
+		if (loop.empty())
+			return;
+
+		std::vector<simd::float_4> frames;
+		renderExport(snap, loop, curve, frames);
+
+		// 帧内 L 在前 2 * width 个 float，R 在后；WAV 中每通道 L/R 相邻
+		int n = snap.channels;
+		int side = 2 * snap.width;
+		size_t numFrames = frames.size() / snap.width;
+		std::vector<float> samples(numFrames * 2 * n);
+		for (size_t i = 0; i < numFrames; i++) {
+			const float* x = reinterpret_cast<const float*>(&frames[i * snap.width]);
+			for (int c = 0; c < n; c++) {
+				samples[(i * n + c) * 2] = x[c];
+				samples[(i * n + c) * 2 + 1] = x[side + c];
+			}
+		}
+
+		if (dir.empty()) {
+			WARN("BuildupLooper: no patch storage directory, loop not exported");
+			return;
+		}
+		system::createDirectories(dir);
+		std::string path;
+		for (int i = 1; i < 1000 && path.empty(); i++) {
+			std::string candidate = system::join(dir, string::f("loop-%03d.wav", i));
+			if (!system::exists(candidate))
+				path = candidate;
+		}
+		if (path.empty()) {
+			WARN("BuildupLooper: loop-001.wav to loop-999.wav already exist in %s, loop not exported", dir.c_str());
+			return;
+		}
+		if (!writeWavFloat(path, samples, 2 * n, (int)std::lround(snap.sampleRate)))
+			WARN("BuildupLooper: could not write %s", path.c_str());
+		else
+			INFO("BuildupLooper: exported loop to %s", path.c_str());
 	}
 
-	// 在 loop 结尾 Nfade 与开头 Nfade 做 crossfade，无爆音
-	float readWithLoopCrossfade(const float* buf, int len, float pos, int Nfade) {
-		if (len <= 0) return 0.f;
-		float p = pos;
-		while (p >= len) p -= len;
-		while (p < 0.f) p += len;
-		float end = readLinear(buf, len, p);
-		if (Nfade <= 0 || len < 2 * Nfade) return end;
-		float startPos = p - (float)(len - Nfade);
-		if (startPos < 0.f) startPos += len;
-		float start = readLinear(buf, len, startPos);
-		float w = 0.f;
-		if (p >= (float)(len - Nfade))
-			w = (p - (float)(len - Nfade)) / (float)Nfade;
-		return end * (1.f - w) + start * w;
+	// 离线渲染：不带曲线时为 loop 一遍（含接缝 crossfade，与循环播放听到的一致）；
+	// 带曲线时按 TIME 秒从 1x 加速到 INTENSITY（与 Accelerate 模式相同的 ease-in-out 与 mip 读取）
+	static void renderExport(const ExportSnapshot& snap, const std::vector<simd::float_4>& loop, bool curve, std::vector<simd::float_4>& frames) {
+		int width = snap.width;
+		std::vector<simd::float_4> levelData[MIP_LEVELS];
+		LoopView levels[MIP_LEVELS];
+		levels[0].buf = loop.data();
+		levels[0].width = width;
+		levels[0].len = snap.len;
+		int count = 1;
+		if (curve) {
+			for (int k = 1; k < MIP_LEVELS && levels[k - 1].len >= MIP_MIN_LEN; k++) {
+				int len = levels[k - 1].len >> 1;
+				levelData[k].resize((size_t)(len + LOOP_GUARD) * width);
+				for (int i = 0; i < len; i++)
+					decimateFrame(levels[k - 1], i, &levelData[k][(size_t)i * width]);
+				for (int g = 0; g < LOOP_GUARD; g++)
+					std::memcpy(&levelData[k][(size_t)(len + g) * width], &levelData[k][(size_t)g * width], sizeof(simd::float_4) * width);
+				levels[k].buf = levelData[k].data();
+				levels[k].width = width;
+				levels[k].len = len;
+				count = k + 1;
+			}
+		}
+
+		int total = curve ? std::max(1, (int)(snap.time * snap.sampleRate)) : snap.len;
+		frames.resize((size_t)total * width);
+		uint64_t loopFixed = (uint64_t)snap.len << PLAYHEAD_FRAC_BITS;
+		uint64_t playhead = 0;
+		for (int i = 0; i < total; i++) {
+			float rate = 1.f;
+			if (curve)
+				rate = 1.f + (snap.intensity - 1.f) * easeInOut((float)i / (float)total);
+			readMip(levels, count, playhead, snap.Nfade, rate, &frames[(size_t)i * width]);
+			playhead += (uint64_t)((double)rate * PLAYHEAD_ONE);
+			playhead -= (playhead >= loopFixed) ? loopFixed : 0;
+		}
 	}
 };
 
@@ -355,6 +1118,27 @@ struct BuildupLooperWidget : ModuleWidget {
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(cx + 8, 102)), module, BuildupLooperModule::AUDIO_R_INPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(cx - 8, 118)), module, BuildupLooperModule::AUDIO_L_OUTPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(cx + 8, 118)), module, BuildupLooperModule::AUDIO_R_OUTPUT));
+
+		// 切片模式：面板右侧一列小旋钮
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(cx + 18.5f, 46)), module, BuildupLooperModule::MODE_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(cx + 18.5f, 56)), module, BuildupLooperModule::SLICE_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(cx + 18.5f, 66)), module, BuildupLooperModule::PATTERN_PARAM));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(cx + 18.5f, 78)), module, BuildupLooperModule::EXPORT_INPUT));
+	}
+
+	void appendContextMenu(ui::Menu* menu) override {
+		BuildupLooperModule* module = dynamic_cast<BuildupLooperModule*>(this->module);
+		assert(module);
+
+		menu->addChild(new ui::MenuSeparator);
+		// 写入补丁存储目录，随补丁一起保存
+		menu->addChild(createMenuItem("Export loop to WAV", "", [=]() {
+			module->exportRequested.store(true);
+		}));
+		menu->addChild(createBoolMenuItem("Export with acceleration curve", "",
+			[=]() { return module->exportCurve.load(); },
+			[=](bool enabled) { module->exportCurve.store(enabled); }
+		));
 	}
 };
 
@@ -1,4 +1,7 @@
 #include "plugin.hpp"
+#include "BandLimitedOscillator.hpp"
+#include "ClockTransport.hpp"
+#include "FastMath.hpp"
 #include <dsp/filter.hpp>
 #include <cmath>
 #include <vector>
@@ -102,23 +105,25 @@ struct Voice {
 		}
 		
 		// Keep phase continuous - don't reset it
-		phase += frequency * sampleTime;
+		float dt = frequency * sampleTime;
+		phase += dt;
 		if (phase >= 1.f) phase -= 1.f;
 		if (phase < 0.f) phase += 1.f;
 		
+		// Band-limited edges (PolyBLEP/PolyBLAMP) instead of naive aliasing shapes
 		float signal = 0.f;
 		switch (waveform) {
 			case SINE:
-				signal = std::sin(2.f * M_PI * phase);
+				signal = FastMath::sin2pi(phase);
 				break;
 			case TRIANGLE:
-				signal = phase < 0.5f ? 4.f * phase - 1.f : 3.f - 4.f * phase;
+				signal = BandLimited::triangle(phase, dt);
 				break;
 			case SAW:
-				signal = 2.f * phase - 1.f;
+				signal = BandLimited::saw(phase, dt);
 				break;
 			case SQUARE:
-				signal = phase < 0.5f ? 1.f : -1.f;
+				signal = BandLimited::square(phase, dt);
 				break;
 		}
 		
@@ -197,6 +202,9 @@ struct ChordPadSynth : Module {
 	float lastClock = 0.f;
 	float lastReset = 0.f;
 	
+	// Transport from an adjacent MidiClockSync, used while the clock input is unpatched
+	ClockTransport::Receiver transport;
+	
 	// Filter for pad sound
 	dsp::RCFilter filter;
 	
@@ -209,6 +217,7 @@ struct ChordPadSynth : Module {
 	
 	ChordPadSynth() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		
 		// Pad preset (0-4)
 		configSwitch(PAD_PRESET_PARAM, 0.f, 4.f, 0.f, "Pad Preset", 
@@ -454,10 +463,15 @@ struct ChordPadSynth : Module {
 			zeroCrossSamples = 0;
 		}
 		
+		// An adjacent MidiClockSync replaces the clock cable with exact bar positions
+		bool transportSync = transport.process(this, args.frame) && !inputs[CLOCK_INPUT].isConnected();
+		
 		// Handle reset input
-		if (inputs[RESET_INPUT].isConnected()) {
+		if (inputs[RESET_INPUT].isConnected() || transportSync) {
 			float reset = inputs[RESET_INPUT].getVoltage();
 			bool resetRising = reset > 1.f && lastReset <= 1.f;
+			if (transportSync && transport.takeReset())
+				resetRising = true;
 			
 			if (resetRising) {
 				// Reset to slot 0
@@ -476,6 +490,12 @@ struct ChordPadSynth : Module {
 				currentSlot = (currentSlot + 1) % 4; // Cycle through 4 slots
 			}
 			lastClock = clock;
+		} else if (transportSync) {
+			// Transport: one chord per bar
+			if (transport.crossed(ClockTransport::TICKS_PER_BEAT * ClockTransport::BEATS_PER_BAR)) {
+				triggerSlot(currentSlot);
+				currentSlot = (currentSlot + 1) % 4;
+			}
 		}
 		
 		// Process envelope
@@ -1,4 +1,7 @@
 #include "plugin.hpp"
+#include "BandLimitedOscillator.hpp"
+#include "ClockTransport.hpp"
+#include "FastMath.hpp"
 #include <dsp/filter.hpp>
 #include <cmath>
 #include <vector>
@@ -111,30 +114,32 @@ struct Voice {
 		}
 		
 		// Keep phase continuous
-		phase += frequency * sampleTime;
+		float dt = frequency * sampleTime;
+		phase += dt;
 		if (phase >= 1.f) phase -= 1.f;
 		if (phase < 0.f) phase += 1.f;
 		
+		// Band-limited edges (PolyBLEP/PolyBLAMP) instead of naive aliasing shapes
 		float signal = 0.f;
 		switch (waveform) {
 			case SINE:
-				signal = std::sin(2.f * M_PI * phase);
+				signal = FastMath::sin2pi(phase);
 				break;
 			case TRIANGLE:
-				signal = phase < 0.5f ? 4.f * phase - 1.f : 3.f - 4.f * phase;
+				signal = BandLimited::triangle(phase, dt);
 				break;
 			case SAW:
-				signal = 2.f * phase - 1.f;
+				signal = BandLimited::saw(phase, dt);
 				break;
 			case SQUARE:
-				signal = phase < 0.5f ? 1.f : -1.f;
+				signal = BandLimited::square(phase, dt);
 				break;
 			case PIANO:
 				// Piano: square wave with harmonics and pluck filter
-				signal = phase < 0.5f ? 1.f : -1.f;
+				signal = BandLimited::square(phase, dt);
 				// Add harmonics
-				signal += 0.5f * std::sin(2.f * M_PI * phase * 2.f);
-				signal += 0.25f * std::sin(2.f * M_PI * phase * 3.f);
+				signal += 0.5f * FastMath::sin2pi(phase * 2.f);
+				signal += 0.25f * FastMath::sin2pi(phase * 3.f);
 				signal /= 1.75f; // Normalize
 				// Apply pluck filter (high frequency rolloff)
 				pluckFilter.setCutoffFreq(0.3f);
@@ -143,9 +148,9 @@ struct Voice {
 				break;
 			case HARP:
 				// Harp: bright sine with harmonics
-				signal = std::sin(2.f * M_PI * phase);
-				signal += 0.3f * std::sin(2.f * M_PI * phase * 2.f);
-				signal += 0.15f * std::sin(2.f * M_PI * phase * 3.f);
+				signal = FastMath::sin2pi(phase);
+				signal += 0.3f * FastMath::sin2pi(phase * 2.f);
+				signal += 0.15f * FastMath::sin2pi(phase * 3.f);
 				signal /= 1.45f;
 				pluckFilter.setCutoffFreq(0.5f);
 				pluckFilter.process(signal);
@@ -153,9 +158,9 @@ struct Voice {
 				break;
 			case ORGAN:
 				// Organ: multiple sine waves
-				signal = std::sin(2.f * M_PI * phase);
-				signal += 0.5f * std::sin(2.f * M_PI * phase * 2.f);
-				signal += 0.33f * std::sin(2.f * M_PI * phase * 3.f);
+				signal = FastMath::sin2pi(phase);
+				signal += 0.5f * FastMath::sin2pi(phase * 2.f);
+				signal += 0.33f * FastMath::sin2pi(phase * 3.f);
 				signal /= 1.83f;
 				pluckFilter.setCutoffFreq(0.4f);
 				pluckFilter.process(signal);
@@ -275,6 +280,9 @@ struct ChordPluckSynth : Module {
 	float lastClockRiseTime = 0.f; // Time of last clock rising edge
 	float estimatedClockPeriod = 0.1f; // Estimated clock period (default 100ms)
 	
+	// Transport from an adjacent MidiClockSync, used while the clock input is unpatched
+	ClockTransport::Receiver transport;
+	
 	// Frequency detection for aux input
 	float detectedFreq = 0.f;
 	float lastAuxSample = 0.f;
@@ -290,6 +298,7 @@ struct ChordPluckSynth : Module {
 	
 	ChordPluckSynth() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		
 		// Pluck preset (0-6)
 		configSwitch(PLUCK_PRESET_PARAM, 0.f, 6.f, 0.f, "Pluck Preset", 
@@ -588,10 +597,15 @@ struct ChordPluckSynth : Module {
 			zeroCrossSamples = 0;
 		}
 		
+		// An adjacent MidiClockSync replaces the clock cable with exact beat positions
+		bool transportSync = transport.process(this, args.frame) && !inputs[CLOCK_INPUT].isConnected();
+		
 		// Handle reset input
-		if (inputs[RESET_INPUT].isConnected()) {
+		if (inputs[RESET_INPUT].isConnected() || transportSync) {
 			float reset = inputs[RESET_INPUT].getVoltage();
 			bool resetRising = reset > 1.f && lastReset <= 1.f;
+			if (transportSync && transport.takeReset())
+				resetRising = true;
 			
 			if (resetRising) {
 				// Reset arpeggiator state
@@ -608,11 +622,13 @@ struct ChordPluckSynth : Module {
 		}
 		
 		// Detect clock and handle arpeggiator
-		if (inputs[CLOCK_INPUT].isConnected()) {
+		if (inputs[CLOCK_INPUT].isConnected() || transportSync) {
 			float clock = inputs[CLOCK_INPUT].getVoltage();
 			
-			// Detect rising edge
+			// Detect rising edge (transport: every quarter note)
 			bool clockRising = clock > 1.f && lastClock <= 1.f;
+			if (transportSync)
+				clockRising = transport.crossed(ClockTransport::TICKS_PER_BEAT);
 			
 			if (clockRising) {
 				// Ensure we have arp notes for current slot
@@ -630,9 +646,12 @@ struct ChordPluckSynth : Module {
 					arpNoteIndex = 0;
 				}
 				
-				// Estimate clock period from last clock pulse
+				// Estimate clock period from last clock pulse; the transport knows it exactly
 				float currentTime = args.frame / args.sampleRate;
-				if (lastClockRiseTime > 0.f) {
+				float transportPeriod = transportSync ? transport.periodSeconds(ClockTransport::TICKS_PER_BEAT, args.sampleTime) : 0.f;
+				if (transportPeriod > 0.f) {
+					estimatedClockPeriod = transportPeriod;
+				} else if (lastClockRiseTime > 0.f) {
 					float period = currentTime - lastClockRiseTime;
 					if (period > 0.001f && period < 10.f) { // Sanity check: 1ms to 10s
 						estimatedClockPeriod = period;
@@ -1,4 +1,6 @@
 #include "plugin.hpp"
+#include "BandLimitedOscillator.hpp"
+#include "FastMath.hpp"
 #include <dsp/filter.hpp>
 #include <dsp/midi.hpp>
 #include <dsp/ringbuffer.hpp>
@@ -179,7 +181,8 @@ struct LFO {
 			freq = rate * tempo / 60.f; // rate in beats per minute
 		}
 		
-		phase += freq * sampleTime;
+		float dt = freq * sampleTime;
+		phase += dt;
 		if (phase >= 1.f) {
 			phase -= 1.f;
 			if (waveform == RANDOM) {
@@ -189,11 +192,12 @@ struct LFO {
 		
 		switch (waveform) {
 			case SINE:
-				return std::sin(2.f * M_PI * phase);
+				return FastMath::sin2pi(phase);
 			case TRIANGLE:
-				return phase < 0.5f ? 4.f * phase - 1.f : 3.f - 4.f * phase;
+				return BandLimited::triangle(phase, dt);
 			case SQUARE:
-				return phase < 0.5f ? 1.f : -1.f;
+				// Band-limited so fast audio-rate LFO squares don't alias
+				return BandLimited::square(phase, dt);
 			case RANDOM:
 				return randomValue;
 			default:
@@ -225,25 +229,27 @@ struct Voice {
 		if (!active) return 0.f;
 		
 		// Calculate actual frequency with detune and cents offset
-		float actualFreq = frequency * std::pow(2.f, (detune + centsOffset / 100.f) / 12.f);
+		float actualFreq = frequency * FastMath::exp2((detune + centsOffset / 100.f) / 12.f);
 		
-		phase += actualFreq * sampleTime;
+		float dt = actualFreq * sampleTime;
+		phase += dt;
 		if (phase >= 1.f) phase -= 1.f;
 		if (phase < 0.f) phase += 1.f;
 		
+		// Band-limited edges (PolyBLEP/PolyBLAMP) instead of naive aliasing shapes
 		float signal = 0.f;
 		switch (waveform) {
 			case SINE:
-				signal = std::sin(2.f * M_PI * phase);
+				signal = FastMath::sin2pi(phase);
 				break;
 			case TRIANGLE:
-				signal = phase < 0.5f ? 4.f * phase - 1.f : 3.f - 4.f * phase;
+				signal = BandLimited::triangle(phase, dt);
 				break;
 			case SAW:
-				signal = 2.f * phase - 1.f;
+				signal = BandLimited::saw(phase, dt);
 				break;
 			case SQUARE:
-				signal = phase < 0.5f ? 1.f : -1.f;
+				signal = BandLimited::square(phase, dt);
 				break;
 		}
 		
@@ -502,9 +508,9 @@ struct ChordSynth : Module {
 	float semitonesToFrequency(float semitones, float rootFreq) {
 		switch (tuningSystem) {
 			case TET_12:
-				return rootFreq * std::pow(2.f, semitones / 12.f);
+				return rootFreq * FastMath::exp2(semitones / 12.f);
 			case TET_24:
-				return rootFreq * std::pow(2.f, semitones / 24.f);
+				return rootFreq * FastMath::exp2(semitones / 24.f);
 			case JUST_INTONATION: {
 				// Just intonation ratios for common intervals
 				float ratio = 1.f;
@@ -517,22 +523,22 @@ struct ChordSynth : Module {
 				else if (std::abs(remainder - 4.f) < 0.1f) ratio = 5.f / 4.f; // major third
 				else if (std::abs(remainder - 7.02f) < 0.1f) ratio = 3.f / 2.f; // perfect fifth
 				else if (std::abs(remainder - 9.69f) < 0.1f) ratio = 5.f / 3.f; // major sixth
-				else ratio = std::pow(2.f, remainder / 12.f); // fallback to 12-TET
+				else ratio = FastMath::exp2(remainder / 12.f); // fallback to 12-TET
 				
-				return rootFreq * std::pow(2.f, octaves) * ratio;
+				return rootFreq * FastMath::exp2Int(octaves) * ratio;
 			}
 			case CUSTOM_CENTS:
 				// Use cents directly (100 cents = 1 semitone)
-				return rootFreq * std::pow(2.f, semitones / 12.f);
+				return rootFreq * FastMath::exp2(semitones / 12.f);
 			default:
-				return rootFreq * std::pow(2.f, semitones / 12.f);
+				return rootFreq * FastMath::exp2(semitones / 12.f);
 		}
 	}
 	
-	// Update chord notes
+	// Update chord notes. Runs every sample while the gate is high, hence FastMath
 	void updateChord(float rootPitch) {
 		rootNote = rootPitch;
-		float rootFreq = dsp::FREQ_C4 * std::pow(2.f, (rootPitch - 60.f) / 12.f);
+		float rootFreq = dsp::FREQ_C4 * FastMath::exp2((rootPitch - 60.f) / 12.f);
 		
 		// Get chord intervals
 		std::vector<float> intervals = getChordIntervals(chordType);
@@ -548,7 +554,8 @@ struct ChordSynth : Module {
 			if (motionPhase >= 1.f) motionPhase -= 1.f;
 			
 			for (size_t i = 0; i < intervals.size(); i++) {
-				float drift = std::sin(2.f * M_PI * motionPhase + i * 0.5f) * 0.5f * motionAmount;
+				// sin(2 pi phase + 0.5 i), with the offset in cycles
+				float drift = FastMath::sin2pi(motionPhase + i * (float)(0.25 / M_PI)) * 0.5f * motionAmount;
 				intervals[i] += drift;
 			}
 		}
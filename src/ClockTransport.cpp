@@ -0,0 +1,132 @@
+#include "ClockTransport.hpp"
+#include <cmath>
+
+namespace ClockTransport {
+
+bool isReceiver(Model* model) {
+	return model != nullptr
+		&& (model == modelChordPluckSynth
+			|| model == modelChordPadSynth
+			|| model == modelBuildupLooper
+			|| model == modelAmbientRandomSynth
+			|| model == modelOrganicParticleSynth
+			|| model == modelStereoEffects);
+}
+
+void send(Module* neighbour, bool neighbourOnRight, const Message& msg) {
+	if (!neighbour || !isReceiver(neighbour->model))
+		return;
+	// A module on our right receives through its left expander and vice versa
+	Module::Expander& expander = neighbourOnRight ? neighbour->leftExpander : neighbour->rightExpander;
+	Message* dst = static_cast<Message*>(expander.producerMessage);
+	if (!dst)
+		return;
+	*dst = msg;
+	expander.messageFlipRequested = true;
+}
+
+void Receiver::attach(Module* module) {
+	module->leftExpander.producerMessage = &leftMessages[0];
+	module->leftExpander.consumerMessage = &leftMessages[1];
+	module->rightExpander.producerMessage = &rightMessages[0];
+	module->rightExpander.consumerMessage = &rightMessages[1];
+}
+
+// A message is current if it is no older than the latency of its path
+static bool isFresh(const Message* msg, int64_t frame) {
+	return msg && msg->frame >= 0 && frame - msg->frame <= msg->hops + 2;
+}
+
+bool Receiver::process(Module* module, int64_t frame) {
+	const Message* fromLeft = module->leftExpander.module
+		? static_cast<const Message*>(module->leftExpander.consumerMessage) : nullptr;
+	const Message* fromRight = module->rightExpander.module
+		? static_cast<const Message*>(module->rightExpander.consumerMessage) : nullptr;
+	if (!isFresh(fromLeft, frame))
+		fromLeft = nullptr;
+	if (!isFresh(fromRight, frame))
+		fromRight = nullptr;
+
+	// With a clock on both sides, the closer one wins
+	const Message* msg = fromLeft;
+	if (fromRight && (!msg || fromRight->hops < msg->hops))
+		msg = fromRight;
+
+	if (!msg) {
+		active = false;
+		lastPosition = -1.0;
+		return false;
+	}
+
+	// Pass the transport on, away from where it came from
+	Message forward = *msg;
+	forward.hops++;
+	if (msg == fromLeft)
+		send(module->rightExpander.module, true, forward);
+	else
+		send(module->leftExpander.module, false, forward);
+
+	bool wasActive = active;
+	state = *msg;
+	state.frame = frame;
+	if (state.running)
+		state.position += (double)(frame - msg->frame) * msg->ticksPerSample;
+	active = true;
+
+	if (!wasActive) {
+		// Joining a running transport: no edge until the next crossing
+		lastResetCount = state.resetCount;
+		lastPosition = state.position;
+		previousPosition = state.position;
+		return true;
+	}
+
+	if (state.resetCount != lastResetCount) {
+		lastResetCount = state.resetCount;
+		resetPending = true;
+		// Just below zero, so the downbeat at position 0 counts as a crossing
+		lastPosition = -1e-9;
+	}
+
+	// Corrections from the PLL may step the position back slightly; hold it
+	// so the same edge never fires twice
+	previousPosition = lastPosition;
+	if (state.position > lastPosition)
+		lastPosition = state.position;
+	return true;
+}
+
+bool Receiver::crossed(double ticks, float* offset) {
+	if (!active || !state.running || ticks <= 0.0)
+		return false;
+	double edge = std::floor(lastPosition / ticks);
+	if (edge <= std::floor(previousPosition / ticks))
+		return false;
+	if (offset) {
+		double past = (lastPosition - edge * ticks) / std::max(state.ticksPerSample, 1e-9);
+		*offset = (float)clamp(past, 0.0, 0.999);
+	}
+	return true;
+}
+
+bool Receiver::takeReset() {
+	bool reset = resetPending;
+	resetPending = false;
+	return reset;
+}
+
+float Receiver::periodSeconds(double ticks, float sampleTime) const {
+	if (state.ticksPerSample <= 0.0)
+		return 0.f;
+	return (float)(ticks / state.ticksPerSample) * sampleTime;
+}
+
+int Receiver::bar() const {
+	return (int)std::floor(std::max(lastPosition, 0.0) / (TICKS_PER_BEAT * BEATS_PER_BAR));
+}
+
+int Receiver::beatInBar() const {
+	return (int)std::floor(std::max(lastPosition, 0.0) / TICKS_PER_BEAT) % BEATS_PER_BAR;
+}
+
+} // namespace ClockTransport
@@ -0,0 +1,81 @@
+#pragma once
+#include "plugin.hpp"
+
+// Transport state shared between MidiClockSync and adjacent PureFreq modules
+// through Rack expander messages.
+//
+// MidiClockSync publishes one Message per sample to each neighbouring
+// receiver. Receivers forward it to the neighbour on their other side, so a
+// row of PureFreq modules touching MidiClockSync all see the same transport.
+// Every hop adds one frame of latency; the frame stamp lets receivers
+// extrapolate the position to the current sample, so beat edges land on the
+// same sample in every module regardless of where it sits in the row.
+// Only a reset cannot be predicted: its downbeat arrives hops + 1 samples late.
+namespace ClockTransport {
+
+// Position unit is the MIDI clock tick (24 PPQN)
+static const double TICKS_PER_BEAT = 24.0;
+static const int BEATS_PER_BAR = 4;
+
+struct Message {
+	// Engine frame the state below was sampled at
+	int64_t frame = -1;
+	// Ticks since the last reset, including the sub-tick fraction
+	double position = 0.0;
+	// Ticks advanced per sample (0 when stopped)
+	double ticksPerSample = 0.0;
+	float bpm = 120.f;
+	bool running = false;
+	// Incremented on every transport reset
+	uint32_t resetCount = 0;
+	// Number of modules the message passed through after MidiClockSync
+	int hops = 0;
+};
+
+// True for the modules that consume and forward the transport
+bool isReceiver(Model* model);
+
+// Writes `msg` into the expander buffer `neighbour` exposes on the side
+// facing the sender. `neighbourOnRight` is the sender's point of view.
+void send(Module* neighbour, bool neighbourOnRight, const Message& msg);
+
+// Consumer side, one per receiving module
+struct Receiver {
+	Message leftMessages[2];
+	Message rightMessages[2];
+
+	// Latest transport extrapolated to the current frame
+	Message state;
+	bool active = false;
+
+	// Edge tracking for crossed(); highest position seen since the last reset
+	double lastPosition = -1.0;
+	double previousPosition = -1.0;
+	uint32_t lastResetCount = 0;
+	bool resetPending = false;
+
+	// Points the module's expander buffers at leftMessages/rightMessages.
+	// Call from the module constructor.
+	void attach(Module* module);
+
+	// Reads the freshest message from either side, forwards it to the
+	// opposite neighbour and updates `state`. Call once at the top of
+	// process(). Returns `active`.
+	bool process(Module* module, int64_t frame);
+
+	// True on the sample where the position crosses a multiple of
+	// `ticks`. `offset` receives how far past the crossing this sample is,
+	// in samples [0, 1), for sub-sample scheduling.
+	bool crossed(double ticks, float* offset = nullptr);
+
+	// True once after the transport was reset or restarted
+	bool takeReset();
+
+	// Length of `ticks` in seconds at the current tempo
+	float periodSeconds(double ticks, float sampleTime) const;
+
+	int bar() const;
+	int beatInBar() const;
+};
+
+} // namespace ClockTransport
@@ -0,0 +1,136 @@
+#pragma once
+#include "plugin.hpp"
+#include <cstring>
+
+// Polynomial approximations for the per-sample hot paths. Every function is a
+// template over float and simd::float_4, so scalar voices and vectorised
+// lanes use the same code and get the same results.
+//
+// Error bounds against the double-precision libm result, checked for both
+// instantiations by tests/FastMathTest.cpp (`make test`), which sweeps 2^24
+// points per domain (log-spaced for log2):
+//
+//   sin2pi(x)   |x| <= 64                    abs error < 2.0e-7
+//   cos2pi(x)   |x| <= 64                    abs error < 2.0e-7
+//   exp2(x)     -126 <= x <= 126             rel error < 1.5e-7
+//   log2(x)     0.5 <= x <= 2                abs error < 2.0e-7
+//               1e-30 <= x <= 1e30 elsewhere rel error < 1.5e-7
+//   tanh(x)     any x                        abs error < 2.5e-7
+//   softClip(x) any x                        within 0.024 of tanh, exactly +-1 for |x| >= 3
+//
+// A float phase far from zero has less fractional resolution, so keep the
+// arguments of sin2pi/cos2pi wrapped to [0, 1) as usual.
+// None of them handle NaN or infinity.
+namespace FastMath {
+
+// 2^n for whole n in [-126, 127], built from the exponent bits
+inline float exp2Int(float n) {
+	int32_t bits = ((int32_t)n + 127) << 23;
+	float r;
+	std::memcpy(&r, &bits, sizeof(r));
+	return r;
+}
+
+inline simd::float_4 exp2Int(simd::float_4 n) {
+	simd::int32_4 bits = (simd::int32_4(n) + 127) << 23;
+	return simd::float_4::cast(bits);
+}
+
+// Splits x > 0 into x = m * 2^e with m in [1, 2)
+inline void frexp2(float x, float& m, float& e) {
+	int32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	e = (float)(((bits >> 23) & 0xff) - 127);
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	std::memcpy(&m, &bits, sizeof(m));
+}
+
+inline void frexp2(simd::float_4 x, simd::float_4& m, simd::float_4& e) {
+	simd::int32_4 bits = simd::int32_4::cast(x);
+	e = simd::float_4((bits >> 23) & 0xff) - 127.f;
+	m = simd::float_4::cast((bits & 0x007fffff) | 0x3f800000);
+}
+
+// sin(2 pi x). Reduced to a quarter cycle, then an odd Taylor polynomial of
+// degree 11 in 2 pi x, whose truncation error on [-pi/2, pi/2] is below 6e-8.
+template <typename T>
+inline T sin2pi(T x) {
+	T y = x - simd::round(x); // [-0.5, 0.5]
+	// Fold onto [0, 0.25] with sin(2 pi (1/2 - a)) = sin(2 pi a). Going through fabs()
+	// keeps -funsafe-math-optimizations from merging the fold back into `x`.
+	T a = simd::fabs(y);
+	a = simd::fmin(a, 0.5f - a);
+	T z = a * (float)(2.0 * M_PI);
+	T z2 = z * z;
+	T p = -2.5052108e-8f;
+	p = p * z2 + 2.7557319e-6f;
+	p = p * z2 - 1.9841270e-4f;
+	p = p * z2 + 8.3333333e-3f;
+	p = p * z2 - 1.6666667e-1f;
+	T s = z + z * z2 * p;
+	return simd::ifelse(y < 0.f, -s, s);
+}
+
+template <typename T>
+inline T cos2pi(T x) {
+	// cos(2 pi y) = sin(2 pi (1/4 - |y|)), reduced first so the shift keeps its precision
+	return sin2pi(0.25f - simd::fabs(x - simd::round(x)));
+}
+
+// 2^x. Rounds to the nearest whole exponent, then a degree 7 Taylor polynomial
+// of e^(f ln 2) for the fraction f in [-0.5, 0.5] (truncation error 5e-9).
+template <typename T>
+inline T exp2(T x) {
+	x = simd::fmin(simd::fmax(x, T(-126.f)), T(126.f));
+	T n = simd::round(x);
+	T f = (x - n) * (float)M_LN2;
+	T p = 1.9841270e-4f;
+	p = p * f + 1.3888889e-3f;
+	p = p * f + 8.3333333e-3f;
+	p = p * f + 4.1666667e-2f;
+	p = p * f + 1.6666667e-1f;
+	p = p * f + 0.5f;
+	p = p * f + 1.f;
+	p = p * f + 1.f;
+	return p * exp2Int(n);
+}
+
+// log2(x) for x > 0. The mantissa is centred on 1 (in [sqrt(1/2), sqrt(2)))
+// and expanded with the atanh series in t = (m - 1) / (m + 1), |t| < 0.172.
+template <typename T>
+inline T log2(T x) {
+	T m, e;
+	frexp2(x, m, e);
+	auto high = m > (float)M_SQRT2;
+	m = simd::ifelse(high, m * 0.5f, m);
+	e = simd::ifelse(high, e + 1.f, e);
+	T t = (m - 1.f) / (m + 1.f);
+	T t2 = t * t;
+	T p = 1.f / 9.f;
+	p = p * t2 + 1.f / 7.f;
+	p = p * t2 + 1.f / 5.f;
+	p = p * t2 + 1.f / 3.f;
+	p = p * t2 + 1.f;
+	return e + t * p * (float)(2.0 / M_LN2);
+}
+
+// tanh(x) = 1 - 2 / (e^(2x) + 1), with e^(2x) from exp2(). Saturated beyond
+// |x| = 9, where tanh is 1 to float precision.
+template <typename T>
+inline T tanh(T x) {
+	x = simd::fmin(simd::fmax(x, T(-9.f)), T(9.f));
+	T e = exp2(x * (float)(2.0 / M_LN2));
+	return 1.f - 2.f / (e + 1.f);
+}
+
+// Cheap tanh-shaped saturator: the [3/2] Pade approximant of tanh, clamped
+// where it reaches +-1 with zero slope. Only multiplies and one division, for
+// drive stages that need the shape rather than exact tanh.
+template <typename T>
+inline T softClip(T x) {
+	x = simd::fmin(simd::fmax(x, T(-3.f)), T(3.f));
+	T x2 = x * x;
+	return x * (27.f + x2) / (27.f + 9.f * x2);
+}
+
+} // namespace FastMath
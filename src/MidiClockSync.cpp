@@ -1,6 +1,182 @@
 #include "plugin.hpp"
+#include "ClockTransport.hpp"
 #include <dsp/digital.hpp>
 
+// Locks a per-sample oscillator to incoming MIDI clock (0xF8) messages.
+// Messages are popped from the InputQueue at their own timestamps, so a tick is
+// handled on the exact sample it was scheduled for. The oscillator then emits
+// the 24 PPQN pulses at its smoothed rate, which keeps driver and DAW timestamp
+// jitter away from the outputs while the pulse count still follows the host 1:1.
+struct MidiClockPll {
+	// Proportional phase correction and relative frequency correction per tick
+	static constexpr double PHASE_GAIN = 0.25;
+	static constexpr double FREQ_GAIN = 0.02;
+	// Phase error (in ticks) above which a tick counts as an outlier
+	static constexpr double LOCK_ERROR = 0.3;
+	// Consecutive outliers before re-acquiring (tempo jump)
+	static constexpr int RELOCK_TICKS = 4;
+	// Host clock considered gone after this many missing ticks
+	static constexpr double TIMEOUT_TICKS = 8.0;
+
+	double phase = 0.0;      // ticks since the last emitted pulse, [0, 1) while locked
+	double increment = 0.0;  // ticks per sample
+	int64_t lastTickFrame = -1;
+	int ticksSeen = 0;
+	int outliers = 0;
+	bool locked = false;
+	bool waitForTick = false;
+
+	void reset() {
+		phase = 0.0;
+		increment = 0.0;
+		lastTickFrame = -1;
+		ticksSeen = 0;
+		outliers = 0;
+		locked = false;
+		waitForTick = false;
+	}
+
+	// After MIDI Start the first 0xF8 is the downbeat: hold pulses until it arrives
+	void start() {
+		waitForTick = true;
+	}
+
+	bool isActive(int64_t frame, float sampleRate) const {
+		if (lastTickFrame < 0)
+			return false;
+		double timeout = locked ? TIMEOUT_TICKS / increment : (double)sampleRate;
+		return (double)(frame - lastTickFrame) < timeout;
+	}
+
+	// Handles one 0xF8 at `frame`. Returns true if a pulse must be emitted on this sample.
+	bool onTick(int64_t frame) {
+		int64_t interval = lastTickFrame >= 0 ? frame - lastTickFrame : 0;
+		lastTickFrame = frame;
+		if (interval <= 0 || !locked) {
+			// Acquiring: follow the messages directly until the interval is known
+			if (interval > 0) {
+				increment = 1.0 / (double)interval;
+				locked = ++ticksSeen >= 2;
+			}
+			phase = 0.0;
+			waitForTick = false;
+			return true;
+		}
+		if (waitForTick) {
+			waitForTick = false;
+			phase = 0.0;
+			return true;
+		}
+		// Error in ticks: positive when the oscillator already emitted this tick
+		double error = phase >= 0.5 ? phase - 1.0 : phase;
+		if (std::fabs(error) > LOCK_ERROR) {
+			if (++outliers >= RELOCK_TICKS) {
+				// Tempo jumped: restart from the measured interval, emitting only if still due
+				outliers = 0;
+				increment = 1.0 / (double)interval;
+				phase = 0.0;
+				return error < 0.0;
+			}
+			return false;
+		}
+		outliers = 0;
+		phase -= PHASE_GAIN * error;
+		increment *= 1.0 - FREQ_GAIN * error;
+		return false;
+	}
+
+	// Advances one sample. Returns true when the oscillator crosses a tick.
+	bool process() {
+		if (!locked || waitForTick)
+			return false;
+		phase += increment;
+		if (phase < 1.0)
+			return false;
+		phase -= 1.0;
+		return true;
+	}
+
+	float getBpm(float sampleRate) const {
+		return (float)(increment * sampleRate * 60.0 / 24.0);
+	}
+};
+
+// Groove applied to a division grid. Step k of a division lasting `ticks` fires at
+// (k + offset(k)) * ticks, where offset(k) combines swing on the odd steps with the
+// shuffle template. Swing is the off-beat position within a pair of steps:
+// 50% straight, 66.7% triplet shuffle, 75% dotted.
+struct Groove {
+	static constexpr int NUM_TEMPLATES = 5;
+	static constexpr int TEMPLATE_STEPS = 4;
+	// Per-step offsets in steps, repeating every four steps. Step 0 stays on the grid
+	static constexpr float TEMPLATES[NUM_TEMPLATES][TEMPLATE_STEPS] = {
+		{0.f, 0.f, 0.f, 0.f},          // Off
+		{0.f, 0.08f, 0.04f, 0.12f},    // Laid back
+		{0.f, -0.08f, 0.f, -0.08f},    // Push
+		{0.f, 0.1f, -0.05f, 0.15f},    // Drunk
+		{0.f, -0.15f, 0.f, 0.f},       // Heartbeat
+	};
+	static constexpr const char* TEMPLATE_NAMES[NUM_TEMPLATES] = {
+		"Off", "Laid back", "Push", "Drunk", "Heartbeat"
+	};
+
+	float swing = 0.5f;
+	int shuffle = 0;
+
+	// Offsets are kept in [-0.2, 0.75] so consecutive steps never swap order
+	double stepTime(int64_t step, double ticks) const {
+		double offset = TEMPLATES[shuffle][step & (TEMPLATE_STEPS - 1)];
+		if (step & 1)
+			offset += 2.0 * swing - 1.0;
+		offset = clamp(offset, -0.2, 0.75);
+		return ((double)step + offset) * ticks;
+	}
+};
+
+// Pulse scheduler for one division. Step times are compared with the master tick
+// position (pulse count + high-resolution phase), so every pulse and ratchet repeat
+// lands on the sample its exact time falls on, not on the 24 PPQN pulse grid.
+struct GrooveTrack {
+	double ticks = 24.0;
+	int64_t nextStep = 1;
+	// Ratchet repeats still due in the current step
+	int ratchetsLeft = 0;
+	double ratchetTime = 0.0;
+	double ratchetSpacing = 0.0;
+
+	// Restarts the grid; step 0 coincides with the reset so the first pulse is step 1.
+	// With `downbeat`, the reset position is itself a pulse and step 0 fires there.
+	void reset(double length, double position, bool downbeat = false) {
+		ticks = length;
+		nextStep = (int64_t)std::floor(position / length) + (downbeat ? 0 : 1);
+		ratchetsLeft = 0;
+	}
+
+	// Returns true if a pulse is due at `position`. `ratchets` splits each step into
+	// that many evenly spaced pulses.
+	bool process(double position, const Groove& groove, int ratchets) {
+		bool fire = false;
+		if (ratchetsLeft > 0 && position >= ratchetTime) {
+			fire = true;
+			ratchetsLeft--;
+			ratchetTime += ratchetSpacing;
+		}
+		double time = groove.stepTime(nextStep, ticks);
+		if (position >= time) {
+			fire = true;
+			double next = groove.stepTime(nextStep + 1, ticks);
+			ratchetsLeft = ratchets - 1;
+			ratchetSpacing = (next - time) / ratchets;
+			ratchetTime = time + ratchetSpacing;
+			nextStep++;
+			// Steps skipped by a position jump (MIDI relock) are dropped, not bunched up
+			while (position >= groove.stepTime(nextStep, ticks))
+				nextStep++;
+		}
+		return fire;
+	}
+};
+
 struct MidiClockSync : Module {
 	enum ParamId {
 		BPM_PARAM,
@@ -8,6 +184,9 @@ struct MidiClockSync : Module {
 		TRIPLET_PARAM,
 		RESET_PARAM,
 		STOP_RUN_PARAM,
+		SWING_PARAM,
+		SHUFFLE_PARAM,
+		RATCHET_PARAM,
 		PARAMS_LEN
 	};
 	enum InputId {
@@ -18,6 +197,7 @@ struct MidiClockSync : Module {
 		CLOCK_OUTPUT,
 		RESET_OUTPUT,
 		TRIGGER_OUTPUT,
+		DIVISIONS_OUTPUT,
 		OUTPUTS_LEN
 	};
 	enum LightId {
@@ -36,25 +216,70 @@ struct MidiClockSync : Module {
 		DIV_1_8 = 5,    // 12 pulses (1/2 beat)
 		DIV_1_16 = 6,   // 6 pulses (1/4 beat)
 		DIV_1_32 = 7,   // 3 pulses (1/8 beat)
-		DIV_1_64 = 8    // 1.5 pulses (1/16 beat) - will use 1 or 2 pulses
+		DIV_1_64 = 8    // 1.5 pulses (1/16 beat), placed from the fractional tick phase
 	};
 
 	// MIDI clock: 24 PPQN (Pulses Per Quarter Note)
 	static constexpr int MIDI_PPQN = 24;
+
+	// Poly division bus: one channel per division, length in ticks (24 PPQN).
+	// Dotted = 3/2, triplet = 2/3 of the straight value; 1/64 falls between ticks
+	// and is placed from the fractional tick phase.
+	static constexpr int NUM_DIVISIONS = 16;
+	static constexpr double DIVISION_TICKS[NUM_DIVISIONS] = {
+		96.0, 48.0, 72.0, 32.0,  // 1/1, 1/2, 1/2., 1/2T
+		24.0, 36.0, 16.0,        // 1/4, 1/4., 1/4T
+		12.0, 18.0, 8.0,         // 1/8, 1/8., 1/8T
+		6.0, 9.0, 4.0,           // 1/16, 1/16., 1/16T
+		3.0, 2.0, 1.5            // 1/32, 1/32T, 1/64
+	};
+	static constexpr const char* DIVISION_NAMES[NUM_DIVISIONS] = {
+		"1/1", "1/2", "1/2.", "1/2T", "1/4", "1/4.", "1/4T", "1/8",
+		"1/8.", "1/8T", "1/16", "1/16.", "1/16T", "1/32", "1/32T", "1/64"
+	};
+	// Swing choices for a single division, as off-beat positions
+	static constexpr int NUM_SWING_STEPS = 7;
+	static constexpr float SWING_STEPS[NUM_SWING_STEPS] = {
+		0.5f, 0.54f, 0.58f, 0.62f, 2.f / 3.f, 0.71f, 0.75f
+	};
 	
-	dsp::Timer clockTimer;
+	midi::InputQueue midiInput;
+	MidiClockPll midiPll;
+
+	// Internal clock phase in MIDI ticks, [0, 1) between pulses
+	double clockPhase = 0.0;
 	dsp::PulseGenerator clockPulse;
 	dsp::PulseGenerator resetPulse;
 	dsp::PulseGenerator triggerPulse;
-	dsp::ClockDivider triggerDivider;
+	dsp::PulseGenerator divisionPulses[NUM_DIVISIONS];
+	// Groove schedulers for the trigger output and each division bus channel
+	Groove groove;
+	GrooveTrack triggerTrack;
+	GrooveTrack divisionTracks[NUM_DIVISIONS];
+	// Per-division groove from the context menu. Swing and shuffle index 0 follows the
+	// panel knobs, otherwise SWING_STEPS / TEMPLATES at index - 1. Ratchet index n is n + 1 pulses.
+	int divisionSwing[NUM_DIVISIONS] = {};
+	int divisionShuffle[NUM_DIVISIONS] = {};
+	int divisionRatchet[NUM_DIVISIONS] = {};
+
+	// Master position in ticks since reset (pulse count + fractional phase), never moves backwards
+	double tickPosition = 0.0;
+	// Sync mode: samples since the last edge and the last edge interval, for the fractional phase
+	int64_t syncSamples = 0;
+	int64_t syncPeriod = 0;
+	// Bumped on every reset so expander receivers can tell a restart from a tempo jump
+	uint32_t transportResets = 0;
+	// Set by MIDI Start: the next 0xF8 is the downbeat at position 0, not tick 1
+	bool downbeatPending = false;
 	
 	uint32_t clockCounter = 0;
-	int currentDivision = 24; // default 1/4
-	float lastBPM = 120.f;
+	double currentDivision = 24.0; // default 1/4
 	bool lastResetButtonState = false;
 	float lastSyncInput = 0.f;
 	bool lastSyncMode = false;
 	bool lastStopRunState = false;
+	bool lastMidiMode = false;
+	float displayBpm = 120.f;
 
 	MidiClockSync() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -72,31 +297,166 @@ struct MidiClockSync : Module {
 		configOutput(CLOCK_OUTPUT, "Clock");
 		configOutput(RESET_OUTPUT, "Reset");
 		configOutput(TRIGGER_OUTPUT, "Trigger");
+		configOutput(DIVISIONS_OUTPUT, "Divisions (16 channels)")->description =
+			"1: 1/1, 2: 1/2, 3: 1/2., 4: 1/2T, 5: 1/4, 6: 1/4., 7: 1/4T, 8: 1/8, "
+			"9: 1/8., 10: 1/8T, 11: 1/16, 12: 1/16., 13: 1/16T, 14: 1/32, 15: 1/32T, 16: 1/64. "
+			"Swing, shuffle and ratchet per channel in the context menu";
 		
 		configLight(RESET_LIGHT, "Reset");
 		configLight(TRIPLET_LIGHT, "Triplet");
 		configLight(STOP_RUN_LIGHT, "Run");
 		
-		triggerDivider.setDivision(24); // default to 1/4
+		configParam(SWING_PARAM, 50.f, 75.f, 50.f, "Swing", "%")->description =
+			"Off-beat position of each division's step pairs: 50% straight, 66.7% triplet, 75% dotted";
+		configSwitch(SHUFFLE_PARAM, 0.f, (float)(Groove::NUM_TEMPLATES - 1), 0.f, "Shuffle",
+			std::vector<std::string>(Groove::TEMPLATE_NAMES, Groove::TEMPLATE_NAMES + Groove::NUM_TEMPLATES));
+		configSwitch(RATCHET_PARAM, 1.f, 4.f, 1.f, "Trigger ratchet", {"1x", "2x", "3x", "4x"});
+		
+		resetGrooveTracks();
+	}
+
+	void resetGrooveTracks(bool downbeat = false) {
+		triggerTrack.reset(currentDivision, tickPosition, downbeat);
+		for (int i = 0; i < NUM_DIVISIONS; i++)
+			divisionTracks[i].reset(DIVISION_TICKS[i], tickPosition, downbeat);
 	}
 	
 	void onReset() override {
-		clockTimer.reset();
+		midiInput.reset();
+		midiPll.reset();
+		lastMidiMode = false;
+		clockPhase = 0.0;
 		clockPulse.reset();
 		resetPulse.reset();
 		triggerPulse.reset();
+		for (int i = 0; i < NUM_DIVISIONS; i++)
+			divisionPulses[i].reset();
 		clockCounter = 0;
-		triggerDivider.reset();
-		currentDivision = 24;
-		lastBPM = 120.f;
+		tickPosition = 0.0;
+		syncSamples = 0;
+		syncPeriod = 0;
+		transportResets++;
+		downbeatPending = false;
+		currentDivision = 24.0;
+		for (int i = 0; i < NUM_DIVISIONS; i++) {
+			divisionSwing[i] = 0;
+			divisionShuffle[i] = 0;
+			divisionRatchet[i] = 0;
+		}
+		resetGrooveTracks();
 		lastSyncInput = 0.f;
 		lastSyncMode = false;
 		lastStopRunState = false;
 	}
 
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "midi", midiInput.toJson());
+		json_t* grooveJ = json_array();
+		for (int i = 0; i < NUM_DIVISIONS; i++) {
+			json_t* divisionJ = json_object();
+			json_object_set_new(divisionJ, "swing", json_integer(divisionSwing[i]));
+			json_object_set_new(divisionJ, "shuffle", json_integer(divisionShuffle[i]));
+			json_object_set_new(divisionJ, "ratchet", json_integer(divisionRatchet[i]));
+			json_array_append_new(grooveJ, divisionJ);
+		}
+		json_object_set_new(rootJ, "divisionGroove", grooveJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* midiJ = json_object_get(rootJ, "midi");
+		if (midiJ)
+			midiInput.fromJson(midiJ);
+		json_t* grooveJ = json_object_get(rootJ, "divisionGroove");
+		for (int i = 0; i < NUM_DIVISIONS; i++) {
+			json_t* divisionJ = grooveJ ? json_array_get(grooveJ, i) : nullptr;
+			if (!divisionJ)
+				break;
+			divisionSwing[i] = clamp((int)json_integer_value(json_object_get(divisionJ, "swing")), 0, NUM_SWING_STEPS);
+			divisionShuffle[i] = clamp((int)json_integer_value(json_object_get(divisionJ, "shuffle")), 0, Groove::NUM_TEMPLATES);
+			divisionRatchet[i] = clamp((int)json_integer_value(json_object_get(divisionJ, "ratchet")), 0, 3);
+		}
+	}
+
+	// Groove of division bus channel `i`: the panel groove with the channel's overrides
+	Groove divisionGroove(int i) const {
+		Groove g = groove;
+		if (divisionSwing[i] > 0)
+			g.swing = SWING_STEPS[divisionSwing[i] - 1];
+		if (divisionShuffle[i] > 0)
+			g.shuffle = divisionShuffle[i] - 1;
+		return g;
+	}
+
+	// 1ms trigger pulse, shortened so fast ratchets stay separate
+	static float pulseWidth(const GrooveTrack& track, int ratchets, double ticksPerSample, float sampleTime) {
+		float width = 1e-3f;
+		if (ratchets > 1 && ticksPerSample > 0.0)
+			width = std::min(width, (float)(0.5 * track.ratchetSpacing / ticksPerSample) * sampleTime);
+		return width;
+	}
+
+	void resetClock() {
+		resetPulse.trigger(1e-3f);
+		clockPhase = 0.0;
+		clockCounter = 0;
+		tickPosition = 0.0;
+		resetGrooveTracks();
+		// After MIDI Start, receivers see the reset on the downbeat tick instead
+		if (!downbeatPending)
+			transportResets++;
+	}
+
+	// First 0xF8 after MIDI Start: position 0, where every grid's step 0 fires
+	void startAtDownbeat() {
+		downbeatPending = false;
+		clockCounter = 0;
+		tickPosition = 0.0;
+		transportResets++;
+		resetGrooveTracks(true);
+	}
+
+	// System real-time messages: clock, start, continue, stop.
+	// Transport drives the Stop/Run button so the panel shows the host state.
+	// Returns true if a clock pulse is due on this sample.
+	bool processMidiMessage(const midi::Message& msg, int64_t frame) {
+		if (msg.getStatus() != 0xf)
+			return false;
+		switch (msg.getChannel()) {
+			case 0x8:  // Timing clock
+				return midiPll.onTick(frame);
+			case 0xa:  // Start: the next tick is the downbeat
+				downbeatPending = true;
+				if (params[STOP_RUN_PARAM].getValue() > 0.5f)
+					resetClock();
+				params[STOP_RUN_PARAM].setValue(1.f);
+				midiPll.start();
+				break;
+			case 0xb:  // Continue: run without resetting the position
+				params[STOP_RUN_PARAM].setValue(1.f);
+				lastStopRunState = true;
+				break;
+			case 0xc:  // Stop
+				params[STOP_RUN_PARAM].setValue(0.f);
+				break;
+			default:
+				break;
+		}
+		return false;
+	}
+
 	void process(const ProcessArgs& args) override {
 		// Get BPM parameter
 		float bpm = params[BPM_PARAM].getValue();
+
+		// MIDI messages are delivered at their timestamps, so each one is handled on its own sample
+		midi::Message msg;
+		bool midiPulse = false;
+		while (midiInput.tryPop(&msg, args.frame)) {
+			if (processMidiMessage(msg, args.frame))
+				midiPulse = true;
+		}
 		
 		// Stop/Run button (latch/toggle)
 		bool stopRunState = params[STOP_RUN_PARAM].getValue() > 0.5f;
@@ -105,10 +465,7 @@ struct MidiClockSync : Module {
 		// Detect transition from stop to run: trigger reset
 		if (isRunning && !lastStopRunState) {
 			// Transition from stop to run: trigger reset
-			resetPulse.trigger(1e-3f);
-			clockTimer.reset();
-			clockCounter = 0;
-			triggerDivider.reset();
+			resetClock();
 		}
 		
 		// Detect transition from run to stop: immediately stop all pulses
@@ -124,24 +481,14 @@ struct MidiClockSync : Module {
 		bool resetButtonState = params[RESET_PARAM].getValue() > 0.5f;
 		if (resetButtonState && !lastResetButtonState) {
 			// Rising edge: trigger reset
-			resetPulse.trigger(1e-3f);
-			clockTimer.reset();
-			clockCounter = 0;
-			triggerDivider.reset();
+			resetClock();
 		}
 		lastResetButtonState = resetButtonState;
 		lights[RESET_LIGHT].setBrightness(resetButtonState ? 1.f : 0.f);
 		
-		// Check if BPM changed significantly (for auto reset)
-		if (std::abs(bpm - lastBPM) > 1.0f) {
-			lastBPM = bpm;
-			clockTimer.reset();
-			clockCounter = 0;
-		}
-		
-		// Calculate clock period (24 PPQN = 24 pulses per quarter note)
-		// Time per pulse = 60 / (BPM * 24) seconds
-		float pulsePeriod = 60.f / (bpm * MIDI_PPQN);
+		// Phase increment per sample in ticks (24 PPQN = 24 pulses per quarter note).
+		// Recomputed every sample, so BPM changes bend the tempo without touching the phase.
+		double tickIncrement = (double)bpm * MIDI_PPQN / (60.0 * (double)args.sampleRate);
 		
 		// Get trigger division parameter (0-8) and triplet mode
 		int divisionIndex = (int)std::round(params[TRIGGER_DIVISION_PARAM].getValue());
@@ -151,69 +498,94 @@ struct MidiClockSync : Module {
 		
 		// Determine division value based on index and triplet mode
 		// Triplet: multiply by 2/3 (same time, 3 notes instead of 2)
-		// Note: 1/64 = 1.5 pulses, we use 1 pulse (closest integer)
-		int division = 24; // default 1/4
+		// Lengths are in ticks and need not be whole: pulses are placed from the tick phase
+		double division = 24.0; // default 1/4
 		switch (divisionIndex) {
-			case DIV_4_1:   division = tripletMode ? 384 : 384; break; // 16 beats (4/1T same as 4/1)
-			case DIV_2_1:   division = tripletMode ? 192 : 192; break; // 8 beats (2/1T same as 2/1)
-			case DIV_1_1:   division = tripletMode ? 96 : 96; break;   // 4 beats (1/1T same as 1/1)
-			case DIV_1_2:   division = tripletMode ? 32 : 48; break;   // 2 beats → 1/2T: 48*2/3=32
-			case DIV_1_4:   division = tripletMode ? 16 : 24; break;   // 1 beat → 1/4T: 24*2/3=16
-			case DIV_1_8:   division = tripletMode ? 8 : 12; break;    // 1/2 beat → 1/8T: 12*2/3=8
-			case DIV_1_16:  division = tripletMode ? 4 : 6; break;     // 1/4 beat → 1/16T: 6*2/3=4
-			case DIV_1_32:  division = tripletMode ? 2 : 3; break;     // 1/8 beat → 1/32T: 3*2/3=2
-			case DIV_1_64:  division = tripletMode ? 1 : 2; break;     // 1/16 beat (1.5→2 pulses, 1/64T→1 pulse: 1.5*2/3=1)
-			default:        division = 24; break;
+			case DIV_4_1:   division = 384.0; break;                     // 16 beats (4/1T same as 4/1)
+			case DIV_2_1:   division = 192.0; break;                     // 8 beats (2/1T same as 2/1)
+			case DIV_1_1:   division = 96.0; break;                      // 4 beats (1/1T same as 1/1)
+			case DIV_1_2:   division = tripletMode ? 32.0 : 48.0; break; // 2 beats → 1/2T: 48*2/3=32
+			case DIV_1_4:   division = tripletMode ? 16.0 : 24.0; break; // 1 beat → 1/4T: 24*2/3=16
+			case DIV_1_8:   division = tripletMode ? 8.0 : 12.0; break;  // 1/2 beat → 1/8T: 12*2/3=8
+			case DIV_1_16:  division = tripletMode ? 4.0 : 6.0; break;   // 1/4 beat → 1/16T: 6*2/3=4
+			case DIV_1_32:  division = tripletMode ? 2.0 : 3.0; break;   // 1/8 beat → 1/32T: 3*2/3=2
+			case DIV_1_64:  division = tripletMode ? 1.0 : 1.5; break;   // 1/16 beat → 1/64T: 1.5*2/3=1
+			default:        division = 24.0; break;
 		}
 		
 		// Update triplet light
 		lights[TRIPLET_LIGHT].setBrightness(tripletMode ? 1.f : 0.f);
 		
-		// Update divider if division changed
+		// Restart the trigger grid from the current position if the division changed
 		if (division != currentDivision) {
 			currentDivision = division;
-			triggerDivider.setDivision(division);
+			triggerTrack.reset(division, tickPosition);
 		}
 		
-		// Check for sync input
+		groove.swing = params[SWING_PARAM].getValue() / 100.f;
+		groove.shuffle = clamp((int)std::round(params[SHUFFLE_PARAM].getValue()), 0, Groove::NUM_TEMPLATES - 1);
+		int ratchets = clamp((int)std::round(params[RATCHET_PARAM].getValue()), 1, 4);
+		
+		// Check for sync input; otherwise follow MIDI clock while the host is sending it
 		bool syncMode = inputs[SYNC_INPUT].isConnected();
+		bool midiMode = !syncMode && midiPll.isActive(args.frame, args.sampleRate);
+		if (midiMode && midiPll.process())
+			midiPulse = true;
+		displayBpm = midiMode && midiPll.locked ? midiPll.getBpm(args.sampleRate) : bpm;
 		
-		// Reset timer when switching from sync mode to internal clock mode
-		if (!syncMode && lastSyncMode) {
-			clockTimer.reset();
+		// Reset timer when switching from sync or MIDI mode to internal clock mode
+		if ((!syncMode && lastSyncMode) || (!midiMode && lastMidiMode)) {
+			clockPhase = 0.0;
+		}
+		if (!midiMode && lastMidiMode) {
+			midiPll.reset();
+		}
+		lastMidiMode = midiMode;
+		// MIDI Start only delivers a downbeat while MIDI drives the clock
+		if (downbeatPending && syncMode) {
+			downbeatPending = false;
+			transportResets++;
 		}
 		
 		// Only generate clock if running
+		bool pulse = false;
+		bool downbeat = false;
+		double fraction = 0.0;
+		double ticksPerSample = 0.0;
 		if (isRunning) {
-			if (syncMode) {
+			if (midiMode) {
+				pulse = midiPulse;
+				downbeat = pulse && downbeatPending;
+				if (midiPll.locked && !midiPll.waitForTick) {
+					fraction = midiPll.phase;
+					ticksPerSample = midiPll.increment;
+				}
+			} else if (syncMode) {
 				// Sync mode: detect rising edge from sync input
 				float syncInput = inputs[SYNC_INPUT].getVoltage();
+				syncSamples++;
 				if (syncInput > 1.f && lastSyncInput <= 1.f) {
 					// Rising edge detected: trigger clock pulse
-					clockPulse.trigger(1e-3f); // 1ms pulse
-					clockCounter++;
-					
-					// Check trigger divider
-					if (triggerDivider.process()) {
-						triggerPulse.trigger(1e-3f); // 1ms trigger pulse
-					}
+					pulse = true;
+					syncPeriod = syncSamples;
+					syncSamples = 0;
+				}
+				if (syncPeriod > 0) {
+					fraction = (double)syncSamples / (double)syncPeriod;
+					ticksPerSample = 1.0 / (double)syncPeriod;
 				}
 				lastSyncInput = syncInput;
 			} else {
-				// Internal clock mode: use timer
-				float elapsed = clockTimer.process(args.sampleTime);
-				
-				// Generate clock pulse every pulsePeriod
-				if (elapsed >= pulsePeriod) {
-					clockTimer.reset();
-					clockPulse.trigger(1e-3f); // 1ms pulse
-					clockCounter++;
-					
-					// Check trigger divider
-					if (triggerDivider.process()) {
-						triggerPulse.trigger(1e-3f); // 1ms trigger pulse
-					}
+				// Internal clock mode: double-precision phase accumulator.
+				// The overshoot past each tick is carried into the next one, so every pulse
+				// lands on the sample where the exact tick time falls and nothing drifts.
+				clockPhase += tickIncrement;
+				if (clockPhase >= 1.0) {
+					clockPhase -= 1.0;
+					pulse = true;
 				}
+				fraction = clockPhase;
+				ticksPerSample = tickIncrement;
 			}
 		} else {
 			// Stop mode: don't process timer or sync input, but still update lastSyncInput to avoid false triggers
@@ -221,6 +593,31 @@ struct MidiClockSync : Module {
 				lastSyncInput = inputs[SYNC_INPUT].getVoltage();
 			}
 		}
+
+		if (pulse) {
+			clockPulse.trigger(1e-3f); // 1ms pulse
+			if (downbeat)
+				startAtDownbeat();
+			else
+				clockCounter++;
+		}
+
+		// Trigger output and division bus: each step fires on the sample where the position
+		// reaches its swung time. The fraction is kept below the next tick so estimated phase
+		// never runs ahead of the pulses. Nothing is scheduled between a MIDI Start and its downbeat.
+		if (isRunning && !downbeatPending) {
+			double position = (double)clockCounter + std::min(fraction, 0.999);
+			if (position > tickPosition || downbeat) {
+				tickPosition = position;
+				if (triggerTrack.process(position, groove, ratchets))
+					triggerPulse.trigger(pulseWidth(triggerTrack, ratchets, ticksPerSample, args.sampleTime));
+				for (int i = 0; i < NUM_DIVISIONS; i++) {
+					int divisionRatchets = divisionRatchet[i] + 1;
+					if (divisionTracks[i].process(position, divisionGroove(i), divisionRatchets))
+						divisionPulses[i].trigger(pulseWidth(divisionTracks[i], divisionRatchets, ticksPerSample, args.sampleTime));
+				}
+			}
+		}
 		
 		lastSyncMode = syncMode;
 		
@@ -237,9 +634,31 @@ struct MidiClockSync : Module {
 		
 		// Output trigger (10V pulse)
 		outputs[TRIGGER_OUTPUT].setVoltage(triggerHigh ? 10.f : 0.f);
+
+		// Division bus (10V pulses)
+		outputs[DIVISIONS_OUTPUT].setChannels(NUM_DIVISIONS);
+		for (int i = 0; i < NUM_DIVISIONS; i++)
+			outputs[DIVISIONS_OUTPUT].setVoltage(divisionPulses[i].process(args.sampleTime) ? 10.f : 0.f, i);
+
+		// Transport for adjacent PureFreq modules, which schedule from it instead of the clock voltage
+		ClockTransport::Message transport;
+		transport.frame = args.frame;
+		transport.position = tickPosition;
+		transport.ticksPerSample = ticksPerSample;
+		transport.bpm = displayBpm;
+		transport.running = isRunning;
+		transport.resetCount = transportResets;
+		ClockTransport::send(rightExpander.module, true, transport);
+		ClockTransport::send(leftExpander.module, false, transport);
 	}
 };
 
+constexpr float Groove::TEMPLATES[Groove::NUM_TEMPLATES][Groove::TEMPLATE_STEPS];
+constexpr const char* Groove::TEMPLATE_NAMES[];
+constexpr double MidiClockSync::DIVISION_TICKS[];
+constexpr const char* MidiClockSync::DIVISION_NAMES[];
+constexpr float MidiClockSync::SWING_STEPS[];
+
 // Latch button for Triplet (toggle on/off)
 struct TripletButton : app::SvgSwitch {
 	TripletButton() {
@@ -265,7 +684,7 @@ struct BpmDisplay : LedDisplay {
 	
 	void step() override {
 		if (module) {
-			float bpm = module->params[MidiClockSync::BPM_PARAM].getValue();
+			float bpm = module->displayBpm;
 			textField->text = string::f("%.0f BPM", bpm);
 		}
 		LedDisplay::step();
@@ -298,6 +717,11 @@ struct MidiClockSyncWidget : ModuleWidget {
 		
 		// Trigger Division knob (snap knob for discrete values 0-8 with labels)
 		addParam(createParamCentered<RoundBlackSnapKnob>(mm2px(Vec(15.24, 55.0)), module, MidiClockSync::TRIGGER_DIVISION_PARAM));
+
+		// MIDI input port selection (driver / device)
+		MidiButton_MIDI_DIN* midiButton = createWidgetCentered<MidiButton_MIDI_DIN>(mm2px(Vec(25.4, 47.5)));
+		midiButton->setMidiPort(module ? &module->midiInput : NULL);
+		addChild(midiButton);
 		
 		// Triplet button (latch/toggle button)
 		addParam(createParamCentered<TripletButton>(mm2px(Vec(15.24, 68.0)), module, MidiClockSync::TRIPLET_PARAM));
@@ -311,6 +735,38 @@ struct MidiClockSyncWidget : ModuleWidget {
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(15.24, 92.0)), module, MidiClockSync::CLOCK_OUTPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(15.24, 104.0)), module, MidiClockSync::RESET_OUTPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(15.24, 116.0)), module, MidiClockSync::TRIGGER_OUTPUT));
+		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(25.4, 92.0)), module, MidiClockSync::DIVISIONS_OUTPUT));
+
+		// Groove: swing, shuffle template, trigger ratchets
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(25.4, 58.0)), module, MidiClockSync::SWING_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(25.4, 67.0)), module, MidiClockSync::SHUFFLE_PARAM));
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(25.4, 76.0)), module, MidiClockSync::RATCHET_PARAM));
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		MidiClockSync* module = getModule<MidiClockSync>();
+		if (!module)
+			return;
+
+		std::vector<std::string> swingLabels = {"Panel"};
+		for (int i = 0; i < MidiClockSync::NUM_SWING_STEPS; i++)
+			swingLabels.push_back(string::f("%.1f%%", MidiClockSync::SWING_STEPS[i] * 100.f));
+		std::vector<std::string> shuffleLabels = {"Panel"};
+		for (int i = 0; i < Groove::NUM_TEMPLATES; i++)
+			shuffleLabels.push_back(Groove::TEMPLATE_NAMES[i]);
+		std::vector<std::string> ratchetLabels = {"1x", "2x", "3x", "4x"};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Division bus groove"));
+		for (int i = 0; i < MidiClockSync::NUM_DIVISIONS; i++) {
+			std::string summary = swingLabels[module->divisionSwing[i]] + ", " + shuffleLabels[module->divisionShuffle[i]]
+				+ ", " + ratchetLabels[module->divisionRatchet[i]];
+			menu->addChild(createSubmenuItem(string::f("%d: %s", i + 1, MidiClockSync::DIVISION_NAMES[i]), summary, [=](Menu* menu) {
+				menu->addChild(createIndexPtrSubmenuItem("Swing", swingLabels, &module->divisionSwing[i]));
+				menu->addChild(createIndexPtrSubmenuItem("Shuffle", shuffleLabels, &module->divisionShuffle[i]));
+				menu->addChild(createIndexPtrSubmenuItem("Ratchet", ratchetLabels, &module->divisionRatchet[i]));
+			}));
+		}
 	}
 };
 
@@ -1,9 +1,14 @@
 #include "plugin.hpp"
+#include "AudioFileDecoder.hpp"
+#include "ClockTransport.hpp"
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <fstream>
 #include <cstring>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <ui/Menu.hpp>
 #include <system.hpp>
 #include <osdialog.h>
@@ -13,110 +18,162 @@
  * 基于 Aetheria 参考实现，支持颗粒合成和外部音频文件加载
  */
 
-// 简单的 WAV 文件读取器（支持 16-bit PCM）
-struct WavReader {
-	static bool loadWavFile(const std::string& path, std::vector<float>& buffer, int& sampleRate) {
-		std::ifstream file(path, std::ios::binary);
-		if (!file.is_open()) return false;
-		
-		// 读取 RIFF 头
-		char riff[4];
-		file.read(riff, 4);
-		if (strncmp(riff, "RIFF", 4) != 0) {
-			file.close();
-			return false;
-		}
-		
-		// 跳过文件大小
-		file.seekg(4, std::ios::cur);
-		
-		// 读取 WAVE 标识
-		char wave[4];
-		file.read(wave, 4);
-		if (strncmp(wave, "WAVE", 4) != 0) {
-			file.close();
-			return false;
-		}
-		
-		// 查找 fmt 块
-		short audioFormat = 0;
-		short numChannels = 0;
-		short bitsPerSample = 0;
-		bool foundFmt = false;
-		
-		while (file.good()) {
-			char chunkId[4];
-			if (!file.read(chunkId, 4)) break;
-			
-			int chunkSize = 0;
-			file.read((char*)&chunkSize, 4);
-			
-			if (strncmp(chunkId, "fmt ", 4) == 0) {
-				file.read((char*)&audioFormat, 2);
-				file.read((char*)&numChannels, 2);
-				file.read((char*)&sampleRate, 4);
-				file.seekg(6, std::ios::cur); // 跳过 byte rate 和 block align
-				file.read((char*)&bitsPerSample, 2);
-				file.seekg(chunkSize - 16, std::ios::cur); // 跳过剩余的 fmt 数据
-				foundFmt = true;
-				break;
-			} else {
-				file.seekg(chunkSize, std::ios::cur);
-			}
+// 窗函数 sinc 重采样器（Blackman-Harris 窗，单侧 32 个过零点），只在加载线程中使用
+// 核函数按每个过零点 256 个相位预先制表，读取时线性插值
+struct SincResampler {
+	static constexpr int ZERO_CROSSINGS = 32;
+	static constexpr int PHASES = 256;
+	static constexpr int KERNEL_SIZE = ZERO_CROSSINGS * PHASES;
+	// kernel[i] 对应 x = i / PHASES（单侧，核函数对称），末尾多一个保护点
+	float kernel[KERNEL_SIZE + 1];
+
+	SincResampler() {
+		for (int i = 0; i < KERNEL_SIZE; i++) {
+			float x = (float)i / PHASES;
+			float sinc = (i == 0) ? 1.f : std::sin((float)M_PI * x) / ((float)M_PI * x);
+			// Blackman-Harris 窗，中心在 x = 0，x = ZERO_CROSSINGS 处归零
+			float w = 0.5f + 0.5f * x / ZERO_CROSSINGS;
+			float window = 0.35875f - 0.48829f * std::cos(2.f * (float)M_PI * w) + 0.14128f * std::cos(4.f * (float)M_PI * w) - 0.01168f * std::cos(6.f * (float)M_PI * w);
+			kernel[i] = sinc * window;
 		}
-		
-		if (!foundFmt || audioFormat != 1) {
-			file.close();
-			return false; // 只支持 PCM
+		kernel[KERNEL_SIZE] = 0.f;
+	}
+
+	float kernelAt(float x) const {
+		x = std::fabs(x) * PHASES;
+		if (x >= (float)KERNEL_SIZE) return 0.f;
+		int i = (int)x;
+		float f = x - (float)i;
+		return kernel[i] + (kernel[i + 1] - kernel[i]) * f;
+	}
+
+	// 将 in（采样率 inRate）转换到 outRate
+	// cutoff 为截止频率占两者中较低奈奎斯特频率的比例，小于 1 时留出过渡带；也可用来生成半带低通副本
+	void process(const std::vector<float>& in, float inRate, float outRate, float cutoff, std::vector<float>& out) const {
+		out.clear();
+		if (in.empty() || inRate <= 0.f || outRate <= 0.f) return;
+		double ratio = (double)inRate / (double)outRate;  // 每个输出采样对应的输入采样数
+		int outLen = (int)((double)in.size() / ratio);
+		out.resize(outLen);
+		// 以输入采样为单位的归一化截止频率；降采样时随输出奈奎斯特频率降低
+		float fc = cutoff * (float)std::min(1.0, 1.0 / ratio);
+		int halfWidth = (int)std::ceil(ZERO_CROSSINGS / fc);
+		int inLen = (int)in.size();
+		for (int n = 0; n < outLen; n++) {
+			double t = n * ratio;
+			int center = (int)t;
+			int k0 = std::max(center - halfWidth + 1, 0);
+			int k1 = std::min(center + halfWidth, inLen - 1);
+			float sum = 0.f;
+			for (int k = k0; k <= k1; k++)
+				sum += in[k] * kernelAt((float)(t - k) * fc);
+			out[n] = sum * fc;
 		}
-		
-		// 查找 data 块
-		int dataSize = 0;
-		bool foundData = false;
-		
-		while (file.good()) {
-			char chunkId[4];
-			if (!file.read(chunkId, 4)) break;
-			
-			file.read((char*)&dataSize, 4);
-			
-			if (strncmp(chunkId, "data", 4) == 0) {
-				foundData = true;
-				break;
-			} else {
-				file.seekg(dataSize, std::ios::cur);
-			}
+	}
+
+	static const SincResampler& get() {
+		static SincResampler instance;
+		return instance;
+	}
+};
+
+// 立体声状态变量滤波器（TPT 结构），float_4 的通道 0/1 分别为左/右声道
+// 截止频率高时比 Biquad 更稳定，参数逐采样变化也不会产生爆音
+struct StereoSVF {
+	simd::float_4 ic1eq = 0.f;
+	simd::float_4 ic2eq = 0.f;
+	float a1 = 1.f, a2 = 0.f, a3 = 0.f;
+	float lastFc = -1.f, lastQ = -1.f;
+
+	// fc 为归一化截止频率（相对采样率），只在参数变化时重新计算系数
+	void setLowpass(float fc, float q) {
+		if (fc == lastFc && q == lastQ) return;
+		lastFc = fc;
+		lastQ = q;
+		float g = std::tan((float)M_PI * fc);
+		float k = 1.f / q;
+		a1 = 1.f / (1.f + g * (g + k));
+		a2 = g * a1;
+		a3 = g * a2;
+	}
+
+	simd::float_4 processLowpass(simd::float_4 v0) {
+		simd::float_4 v3 = v0 - ic2eq;
+		simd::float_4 v1 = a1 * ic1eq + a2 * v3;
+		simd::float_4 v2 = ic2eq + a2 * ic1eq + a3 * v3;
+		ic1eq = 2.f * v1 - ic1eq;
+		ic2eq = 2.f * v2 - ic2eq;
+		return v2;
+	}
+};
+
+// 颗粒窗函数查找表：启动时计算一次，峰值归一化为 1，两端为 0
+// 按颗粒的归一化 age 线性插值读取，每采样只需一次查表，替代逐采样分段计算的梯形包络
+struct GrainWindowTables {
+	enum Type {
+		HANN,
+		TUKEY,
+		GAUSSIAN,
+		EXPODEC,
+		NUM_TYPES
+	};
+	static constexpr int SIZE = 1024;
+	// 第 i 点对应 x = i / (SIZE - 1)，末尾多一个保护点便于插值
+	float tables[NUM_TYPES][SIZE + 1];
+
+	GrainWindowTables() {
+		for (int i = 0; i < SIZE; i++) {
+			float x = (float)i / (float)(SIZE - 1);
+			tables[HANN][i] = hann(x);
+			tables[TUKEY][i] = tukey(x);
+			tables[GAUSSIAN][i] = gaussian(x);
+			tables[EXPODEC][i] = expodec(x);
 		}
-		
-		if (!foundData) {
-			file.close();
-			return false;
+		for (int t = 0; t < NUM_TYPES; t++) {
+			float peak = 0.f;
+			for (int i = 0; i < SIZE; i++)
+				peak = std::max(peak, tables[t][i]);
+			for (int i = 0; i < SIZE; i++)
+				tables[t][i] /= peak;
+			tables[t][SIZE] = tables[t][SIZE - 1];
 		}
-		
-		// 读取音频数据
-		if (bitsPerSample == 16) {
-			int numSamples = dataSize / 2 / numChannels;
-			buffer.resize(numSamples);
-			
-			short* samples = new short[numSamples * numChannels];
-			file.read((char*)samples, dataSize);
-			
-			// 转换为浮点数并混合多声道
-			for (int i = 0; i < numSamples; i++) {
-				float sum = 0.f;
-				for (int ch = 0; ch < numChannels; ch++) {
-					sum += (float)samples[i * numChannels + ch] / 32768.f;
-				}
-				buffer[i] = sum / numChannels;
-			}
-			delete[] samples;
-		} else {
-			file.close();
-			return false; // 只支持 16-bit
-		}
-		
-		file.close();
-		return true;
+	}
+
+	static float hann(float x) {
+		return 0.5f - 0.5f * std::cos(2.f * (float)M_PI * x);
+	}
+
+	// 两侧各 25% 余弦过渡，中间平坦（接近原来的梯形包络）
+	static float tukey(float x) {
+		const float alpha = 0.5f;
+		float edge = alpha * 0.5f;
+		if (x < edge)
+			return 0.5f - 0.5f * std::cos((float)M_PI * x / edge);
+		if (x > 1.f - edge)
+			return 0.5f - 0.5f * std::cos((float)M_PI * (1.f - x) / edge);
+		return 1.f;
+	}
+
+	// 减去端点值，保证两端精确为 0
+	static float gaussian(float x) {
+		const float sigma = 0.15f;
+		auto g = [=](float u) {
+			float d = (u - 0.5f) / sigma;
+			return std::exp(-0.5f * d * d);
+		};
+		return std::max(g(x) - g(0.f), 0.f);
+	}
+
+	// 指数衰减（打击感），前 1% 短暂淡入避免爆音，末端归零
+	static float expodec(float x) {
+		const float k = 5.f;
+		float decay = (std::exp(-k * x) - std::exp(-k)) / (1.f - std::exp(-k));
+		return decay * std::min(x * 100.f, 1.f);
+	}
+
+	static const GrainWindowTables& get() {
+		static GrainWindowTables instance;
+		return instance;
 	}
 };
 
@@ -131,11 +188,17 @@ struct OrganicParticleSynth : Module {
 		BPM_PARAM,            // BPM 主控
 		VOLUME_PARAM,         // 输出音量
 		IS432HZ_PARAM,        // 432Hz 调音按钮
+		WINDOW_PARAM,         // 颗粒窗函数
+		LIVE_DELAY_PARAM,     // 实时输入模式：颗粒相对写入头的延迟
+		SPREAD_PARAM,         // 颗粒立体声散布宽度
 		PARAMS_LEN
 	};
 	enum InputId {
 		CLOCK_INPUT,          // 外部时钟输入
 		VITALITY_CV_INPUT,    // Vitality CV 输入
+		IN_L_INPUT,           // 实时音频输入（左），接入后切换为实时颗粒模式
+		IN_R_INPUT,           // 实时音频输入（右），未接时使用左声道
+		FREEZE_INPUT,         // FREEZE 门信号：高电平时停止写入捕获环
 		INPUTS_LEN
 	};
 	enum OutputId {
@@ -149,39 +212,137 @@ struct OrganicParticleSynth : Module {
 		LIGHTS_LEN
 	};
 
-	// 颗粒合成状态
-	struct Grain {
-		bool active = false;
-		float phase = 0.f;        // 在采样中的位置（采样索引）
-		float duration = 0.f;      // 颗粒持续时间
-		float elapsed = 0.f;       // 已播放时间
-		float startPos = 0.f;      // 采样起始位置（秒）
-		float playbackRate = 1.f;   // 播放速度
-		float envelope = 0.f;      // 包络值
-	};
+	// 颗粒池：结构数组（SoA）布局，4 个一组用 float_4 渲染
+	// 活跃颗粒紧密排列在 [0, count)，其后的槽位即空闲列表：分配取 count，回收时用末尾颗粒填补空位
+	static constexpr int MAX_GRAINS = 256;
+	struct GrainPool {
+		alignas(16) float pos[MAX_GRAINS];      // 在采样中的位置（采样索引）
+		alignas(16) float inc[MAX_GRAINS];      // 每个引擎采样的位置增量（已含播放速度）
+		alignas(16) float age[MAX_GRAINS];      // 归一化已播放时间 [0, 1)
+		alignas(16) float ageInc[MAX_GRAINS];   // 每个引擎采样的 age 增量 = sampleTime / duration
+		alignas(16) float gainL[MAX_GRAINS];    // 等功率声像增益
+		alignas(16) float gainR[MAX_GRAINS];
+		alignas(16) float end[MAX_GRAINS];      // 可读取的最大位置（所在 mip 层长度 - 2）
+		alignas(16) float tilt[MAX_GRAINS];     // 每颗粒音色倾斜 [-1, 1]，负值偏暗、正值偏亮
+		alignas(16) float tiltZL[MAX_GRAINS];   // 倾斜滤波器（一阶低通）状态
+		alignas(16) float tiltZR[MAX_GRAINS];
+		int level[MAX_GRAINS];                  // 读取的 mip 层
+		int count = 0;
+
+		void clearSlot(int i) {
+			pos[i] = 0.f;
+			inc[i] = 0.f;
+			age[i] = 0.f;
+			ageInc[i] = 0.f;
+			gainL[i] = 0.f;
+			gainR[i] = 0.f;
+			end[i] = 0.f;
+			tilt[i] = 0.f;
+			tiltZL[i] = 0.f;
+			tiltZR[i] = 0.f;
+			level[i] = 0;
+		}
+
+		void clear() {
+			for (int i = 0; i < MAX_GRAINS; i++)
+				clearSlot(i);
+			count = 0;
+		}
 
-	static constexpr int MAX_GRAINS = 32;
-	Grain grains[MAX_GRAINS];
+		// 回收颗粒 i：末尾颗粒移入空位，空出的末尾槽位清零（保证 4 路对齐的尾部通道静音）
+		void release(int i) {
+			int last = --count;
+			if (i != last) {
+				pos[i] = pos[last];
+				inc[i] = inc[last];
+				age[i] = age[last];
+				ageInc[i] = ageInc[last];
+				gainL[i] = gainL[last];
+				gainR[i] = gainR[last];
+				end[i] = end[last];
+				tilt[i] = tilt[last];
+				tiltZL[i] = tiltZL[last];
+				tiltZR[i] = tiltZR[last];
+				level[i] = level[last];
+			}
+			clearSlot(last);
+		}
+	};
+	GrainPool grains;
 	
-	// 采样缓冲区
-	std::vector<float> sampleBuffer;
+	// 播放用采样缓冲区，均已在加载线程中转换到引擎采样率
+	// LEVEL_UP2X / LEVEL_HALFBAND 仅在开启高质量变调时生成：音高 < 1 时读 2x 过采样层以降低线性插值误差，
+	// 音高 > √2 时读半带低通层以避免混叠
+	enum SampleLevel {
+		LEVEL_BASE,
+		LEVEL_UP2X,
+		LEVEL_HALFBAND,
+		NUM_LEVELS
+	};
+	std::vector<float> sampleLevels[NUM_LEVELS];
 	float sampleDuration = 0.f;    // 采样时长（秒）
-	int sampleBufferSize = 0;
+	int sampleBufferSize = 0;      // LEVEL_BASE 长度
 	int sampleRate = 44100;
-	bool sampleLoaded = false;
-	std::string samplePath;
+	std::atomic<bool> sampleLoaded{false};
+	std::string samplePath;        // 采样文件路径（保存到补丁中）；只在 UI/引擎线程读写
+	bool embedSample = false;      // 保存补丁时把采样复制到补丁存储目录
+	bool added = false;            // 已加入引擎（onAdd 之后补丁存储目录才可用）
+	std::atomic<bool> hqPitch{false};  // 高质量变调（生成 mip 层）
+
+	// 加载线程：解码与重采样都在这里完成，完成后在 sampleMutex 下交换缓冲区
+	// 音频线程只 try_lock，交换期间本帧颗粒静音，不会阻塞
+	// 常驻线程：请求只写入下面的待办槽位并唤醒它，引擎/UI 线程从不等待解码完成
+	std::thread loaderThread;
+	std::mutex loaderMutex;        // 保护待办槽位；请求可能同时来自 UI 线程与引擎线程
+	std::condition_variable loaderWake;
+	bool loaderQuit = false;
+	bool rebuildPending = false;   // 按 pendingRate 重建播放缓冲区
+	bool decodePending = false;    // 重建前先解码 pendingPath
+	std::string pendingPath;
+	float pendingRate = 0.f;
+	std::mutex sampleMutex;
+	// 原始采样（文件采样率），仅加载线程访问；为空时使用默认合成采样
+	std::vector<float> sourceBuffer;
+	float sourceRate = 0.f;
+	// 缓冲区已被加载线程替换，音频线程在持锁时清空旧颗粒
+	std::atomic<bool> sampleChanged{false};
+
+	// 实时输入捕获环（2 的幂长度，按掩码回绕），只在 onSampleRateChange 中分配
+	// 音频线程只写入/读取，不分配也不加锁
+	static constexpr float LIVE_RING_SECONDS = 4.f;   // 覆盖最大延迟 + 抖动 + 颗粒读取跨度
+	static constexpr float LIVE_MAX_DELAY = 2.f;
+	static constexpr float LIVE_MAX_JITTER = 0.5f;
+	std::vector<float> liveRingL;
+	std::vector<float> liveRingR;
+	uint32_t liveMask = 0;
+	uint32_t liveWrite = 0;
+	bool liveMode = false;
 	
 	// 颗粒调度器
-	float grainTimer = 0.f;
+	// 以采样计数为时间轴（double 精确到 2^53 个采样，长时间运行不漂移）
+	uint64_t sampleCounter = 0;
+	double nextGrainTime = 0.0;     // 下一个颗粒的起始时间（采样，可含小数）
+	double lastGrainTime = -1e9;    // 上一个调度点
+	bool forceNextGrain = false;    // 时钟沿上的颗粒不受密度概率影响
+	// 外部时钟：亚采样定位的上升沿时间与测得的周期
+	double lastClockEdge = -1.0;
+	double clockPeriod = 0.0;       // 0 表示尚未测得
+	float lastClockVoltage = 0.f;
+	// 相邻 MidiClockSync 的走带信息，CLOCK 未接线时直接给出拍位置与周期
+	ClockTransport::Receiver transport;
 
-	// 滤波器
-	dsp::BiquadFilter filter;
+	// 立体声低通滤波器
+	StereoSVF filter;
+	// 每颗粒倾斜滤波（可选）：一阶低通分频点约 1kHz
+	bool grainTilt = false;
+	static constexpr float TILT_FREQ = 1000.f;
 
 	// 触发器
 	dsp::SchmittTrigger clockTrigger;
 
 	OrganicParticleSynth() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		
 		configParam(VITALITY_PARAM, 0.f, 1.f, 0.3f, "Vitality");
 		configParam(PITCH_PARAM, 0.5f, 2.0f, 1.0f, "Pitch/Speed");
@@ -193,122 +354,469 @@ struct OrganicParticleSynth : Module {
 		configParam(VOLUME_PARAM, 0.f, 1.f, 0.5f, "Volume");
 		// 432Hz：0=标准调音，1=432 调音，默认 1（开启）；用开关保持状态
 		configSwitch(IS432HZ_PARAM, 0.f, 1.f, 1.f, "432Hz Tuning");
+		configSwitch(WINDOW_PARAM, 0.f, GrainWindowTables::NUM_TYPES - 1, GrainWindowTables::TUKEY, "Grain Window", {"Hann", "Tukey", "Gaussian", "Expodec"});
+		configParam(LIVE_DELAY_PARAM, 0.f, LIVE_MAX_DELAY, 0.25f, "Live Delay", " s");
+		configParam(SPREAD_PARAM, 0.f, 1.f, 0.5f, "Stereo Spread", "%", 0.f, 100.f);
 
 		configInput(CLOCK_INPUT, "Clock");
 		configInput(VITALITY_CV_INPUT, "Vitality CV");
+		configInput(IN_L_INPUT, "Live audio left");
+		configInput(IN_R_INPUT, "Live audio right");
+		configInput(FREEZE_INPUT, "Freeze gate");
 
 		configOutput(L_OUTPUT, "Left");
 		configOutput(R_OUTPUT, "Right");
 
-		// 初始化默认采样缓冲区
-		onSampleRateChange();
+		grains.clear();
+		allocateLiveRing(APP->engine->getSampleRate());
+
+		// 初始化默认采样缓冲区（构造时音频线程尚未运行，直接同步生成）
+		rebuildSample(APP->engine->getSampleRate());
+		loaderThread = std::thread([this]() { loaderWorker(); });
+	}
+
+	~OrganicParticleSynth() {
+		{
+			std::lock_guard<std::mutex> lock(loaderMutex);
+			loaderQuit = true;
+		}
+		loaderWake.notify_one();
+		if (loaderThread.joinable())
+			loaderThread.join();
+	}
+
+	// 请求加载线程按 engineRate 重建播放缓冲区；decodePath 非空时先解码该文件
+	// 尚未开始的请求被合并：只保留最新的采样率，解码请求只保留最新的文件
+	void requestLoad(float engineRate, const std::string& decodePath = "") {
+		{
+			std::lock_guard<std::mutex> lock(loaderMutex);
+			pendingRate = engineRate;
+			rebuildPending = true;
+			if (!decodePath.empty()) {
+				pendingPath = decodePath;
+				decodePending = true;
+			}
+		}
+		loaderWake.notify_one();
+	}
+
+	void loaderWorker() {
+		std::unique_lock<std::mutex> lock(loaderMutex);
+		while (true) {
+			loaderWake.wait(lock, [this]() { return loaderQuit || rebuildPending; });
+			if (loaderQuit)
+				return;
+			bool decode = decodePending;
+			std::string path = pendingPath;
+			float engineRate = pendingRate;
+			decodePending = false;
+			rebuildPending = false;
+			lock.unlock();
+
+			if (decode)
+				decodeSample(path);
+			// 解码期间到达的新请求会再重建一次，这次的重采样可以跳过
+			lock.lock();
+			if (rebuildPending)
+				continue;
+			lock.unlock();
+			rebuildSample(engineRate);
+			lock.lock();
+		}
+	}
+
+	// 按采样率分配捕获环；引擎在调用 onSampleRateChange 时不会并发执行 process()
+	void allocateLiveRing(float rate) {
+		uint32_t size = 1;
+		while ((float)size < LIVE_RING_SECONDS * rate)
+			size <<= 1;
+		liveRingL.assign(size, 0.f);
+		liveRingR.assign(size, 0.f);
+		liveMask = size - 1;
+		liveWrite = 0;
+		if (liveMode)
+			grains.clear();
 	}
 
 	void onSampleRateChange() override {
-		// 如果没有加载外部采样，生成默认采样
-		if (!sampleLoaded) {
-			float sampleRate = APP->engine->getSampleRate();
-			sampleDuration = 2.0f;
-			sampleBufferSize = (int)(sampleDuration * sampleRate);
-			sampleBuffer.resize(sampleBufferSize, 0.f);
-			
-			// 生成一个复杂的采样（使用可听频率）
-			for (int i = 0; i < sampleBufferSize; i++) {
-				float t = (float)i / sampleRate; // 使用实际时间（秒）
-				// 生成一个衰减的正弦波，带有谐波（使用可听频率）
-				float sample = 0.f;
-				sample += std::sin(2.f * M_PI * 110.f * t) * (1.f - t * 0.5f); // 110Hz 基频
-				sample += std::sin(2.f * M_PI * 220.f * t) * 0.3f * (1.f - t * 0.5f); // 二次谐波
-				sample += std::sin(2.f * M_PI * 330.f * t) * 0.2f * (1.f - t * 0.5f); // 三次谐波
-				sampleBuffer[i] = sample * 0.5f; // 归一化
+		allocateLiveRing(APP->engine->getSampleRate());
+		// 以采样为单位的时钟周期在新采样率下无效，重新测量
+		lastClockEdge = -1.0;
+		clockPeriod = 0.0;
+
+		// APP 只在引擎/UI 线程有效，先取出采样率再交给加载线程
+		requestLoad(APP->engine->getSampleRate());
+	}
+
+	// 生成默认采样：2 秒衰减的 110Hz 谐波音（使用可听频率）
+	static void generateDefaultSample(float rate, std::vector<float>& out) {
+		int size = (int)(2.0f * rate);
+		out.resize(size);
+		for (int i = 0; i < size; i++) {
+			float t = (float)i / rate; // 使用实际时间（秒）
+			float sample = 0.f;
+			sample += std::sin(2.f * M_PI * 110.f * t) * (1.f - t * 0.5f); // 110Hz 基频
+			sample += std::sin(2.f * M_PI * 220.f * t) * 0.3f * (1.f - t * 0.5f); // 二次谐波
+			sample += std::sin(2.f * M_PI * 330.f * t) * 0.2f * (1.f - t * 0.5f); // 三次谐波
+			out[i] = sample * 0.5f; // 归一化
+		}
+	}
+
+	// 把源采样转换为引擎采样率下的播放缓冲区（及可选的 mip 层），然后交换给音频线程
+	// 在加载线程中调用（构造函数中例外）
+	void rebuildSample(float engineRate) {
+		const SincResampler& resampler = SincResampler::get();
+		std::vector<float> levels[NUM_LEVELS];
+
+		bool hq = hqPitch;
+
+		if (sourceBuffer.empty()) {
+			generateDefaultSample(engineRate, levels[LEVEL_BASE]);
+			if (hq) {
+				resampler.process(levels[LEVEL_BASE], engineRate, 2.f * engineRate, 0.95f, levels[LEVEL_UP2X]);
+				resampler.process(levels[LEVEL_BASE], engineRate, engineRate, 0.5f, levels[LEVEL_HALFBAND]);
 			}
-			this->sampleRate = (int)sampleRate;
+		} else {
+			if (sourceRate == engineRate)
+				levels[LEVEL_BASE] = sourceBuffer;
+			else
+				resampler.process(sourceBuffer, sourceRate, engineRate, 0.95f, levels[LEVEL_BASE]);
+			if (hq) {
+				resampler.process(sourceBuffer, sourceRate, 2.f * engineRate, 0.95f, levels[LEVEL_UP2X]);
+				resampler.process(sourceBuffer, sourceRate, engineRate, 0.5f * 0.95f, levels[LEVEL_HALFBAND]);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sampleMutex);
+			for (int l = 0; l < NUM_LEVELS; l++)
+				std::swap(sampleLevels[l], levels[l]);
+			sampleBufferSize = (int)sampleLevels[LEVEL_BASE].size();
+			sampleRate = (int)engineRate;
+			sampleDuration = (float)sampleBufferSize / engineRate;
+			// 旧颗粒的位置指向旧缓冲区，由音频线程清空（实时模式下颗粒不读采样缓冲区，不受影响）
+			sampleChanged = true;
 		}
+		// 旧缓冲区在锁外随 levels 析构释放
 	}
 
 	void loadSampleFile(const std::string& path) {
-		std::vector<float> newBuffer;
-		int newSampleRate = 44100;
-		
-		if (WavReader::loadWavFile(path, newBuffer, newSampleRate)) {
-			sampleBuffer = newBuffer;
-			sampleBufferSize = (int)newBuffer.size();
-			sampleRate = newSampleRate;
-			sampleDuration = (float)sampleBufferSize / sampleRate;
+		// 即使加载失败也保留路径，避免重新保存补丁时丢失引用
+		samplePath = path;
+		decodeSampleAsync(path);
+	}
+
+	// 在加载线程中解码 path，完成前继续播放当前采样（默认音色）
+	void decodeSampleAsync(const std::string& path) {
+		requestLoad(APP->engine->getSampleRate(), path);
+	}
+
+	// 在加载线程中调用
+	void decodeSample(const std::string& path) {
+		// 支持 WAV / AIFF / FLAC，多声道混合为单声道
+		AudioFileDecoder::Audio audio;
+		if (AudioFileDecoder::decode(path, audio)) {
+			AudioFileDecoder::mixToMono(audio, sourceBuffer);
+			sourceRate = (float)audio.sampleRate;
 			sampleLoaded = true;
-			samplePath = path;
 		} else {
 			// 加载失败，使用默认采样
+			sourceBuffer.clear();
 			sampleLoaded = false;
-			onSampleRateChange();
 		}
 	}
 
-	void triggerGrain(float time, float grainSize, float pitch, float vitality) {
-		if (sampleBufferSize == 0) return;
-
-		// 查找空闲的颗粒
-		for (int i = 0; i < MAX_GRAINS; i++) {
-			if (!grains[i].active) {
-				grains[i].active = true;
-				grains[i].elapsed = 0.f;
-				grains[i].duration = grainSize;
-				grains[i].playbackRate = pitch;
-				
-				// 计算起始位置：基础偏移 + Vitality 带来的抖动
-				float baseOffset = 0.1f * sampleDuration;
-				float jitter = vitality * sampleDuration * 0.4f;
-				float startPos = baseOffset + (random::uniform() - 0.5f) * jitter;
-				startPos = clamp(startPos, 0.f, sampleDuration - grainSize);
-				grains[i].startPos = startPos;
-				// 将时间位置转换为采样索引
-				grains[i].phase = startPos * sampleBufferSize / sampleDuration;
-				grains[i].envelope = 0.f;
-				break;
-			}
+	void setHqPitch(bool enabled) {
+		if (enabled == hqPitch) return;
+		hqPitch = enabled;
+		requestLoad(APP->engine->getSampleRate());
+	}
+
+	// 补丁存储目录中的采样副本文件名
+	std::string embeddedSampleName() const {
+		return "sample" + system::getExtension(samplePath);
+	}
+
+	// 优先使用补丁内的副本，其次是原路径；都不存在时保持默认音色
+	// 需要补丁存储目录，只在 onAdd 之后调用
+	void decodeSavedSample() {
+		if (samplePath.empty()) return;
+		std::string decodePath = samplePath;
+		if (embedSample) {
+			std::string storedPath = system::join(getPatchStorageDirectory(), embeddedSampleName());
+			if (system::isFile(storedPath))
+				decodePath = storedPath;
 		}
+		if (system::isFile(decodePath))
+			decodeSampleAsync(decodePath);
 	}
 
-	float processGrain(Grain& grain, float dt) {
-		if (!grain.active) return 0.f;
+	void onAdd(const AddEvent& e) override {
+		added = true;
+		decodeSavedSample();
+	}
 
-		grain.elapsed += dt;
-		
-		// 包络：攻击和释放
-		float attack = grain.duration * 0.1f;
-		float release = grain.duration * 0.4f;
-		
-		if (grain.elapsed < attack) {
-			grain.envelope = grain.elapsed / attack;
-		} else if (grain.elapsed < grain.duration - release) {
-			grain.envelope = 1.f;
-		} else {
-			float releaseTime = grain.elapsed - (grain.duration - release);
-			grain.envelope = 1.f - (releaseTime / release);
+	void onRemove(const RemoveEvent& e) override {
+		added = false;
+	}
+
+	void onSave(const SaveEvent& e) override {
+		std::string dir = getPatchStorageDirectory();
+		bool embedded = embedSample && !samplePath.empty();
+		// 原文件不存在时（例如补丁在另一台机器上打开）保留已有副本
+		if (embedded && system::isFile(samplePath)) {
+			dir = createPatchStorageDirectory();
+			system::copy(samplePath, system::join(dir, embeddedSampleName()));
+		}
+		// 删除其余副本：关闭嵌入后的副本，以及换成其他扩展名的采样后留下的旧副本
+		if (!system::isDirectory(dir)) return;
+		for (const std::string& entry : system::getEntries(dir)) {
+			if (system::getStem(entry) != "sample")
+				continue;
+			if (embedded && system::getFilename(entry) == embeddedSampleName())
+				continue;
+			system::remove(entry);
 		}
+	}
 
-		// 更新相位（基于采样索引，考虑播放速度）
-		float phaseIncrement = dt * grain.playbackRate * sampleBufferSize / sampleDuration;
-		grain.phase += phaseIncrement;
-		
-		// 检查是否超出采样范围或持续时间
-		if (grain.phase >= sampleBufferSize || grain.elapsed >= grain.duration) {
-			grain.active = false;
-			return 0.f;
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "hqPitch", json_boolean(hqPitch.load()));
+		json_object_set_new(rootJ, "samplePath", json_string(samplePath.c_str()));
+		json_object_set_new(rootJ, "embedSample", json_boolean(embedSample));
+		json_object_set_new(rootJ, "grainTilt", json_boolean(grainTilt));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* hqPitchJ = json_object_get(rootJ, "hqPitch");
+		if (hqPitchJ)
+			setHqPitch(json_boolean_value(hqPitchJ));
+
+		json_t* embedSampleJ = json_object_get(rootJ, "embedSample");
+		if (embedSampleJ)
+			embedSample = json_boolean_value(embedSampleJ);
+
+		json_t* grainTiltJ = json_object_get(rootJ, "grainTilt");
+		if (grainTiltJ)
+			grainTilt = json_boolean_value(grainTiltJ);
+
+		json_t* samplePathJ = json_object_get(rootJ, "samplePath");
+		if (samplePathJ && json_string_value(samplePathJ)) {
+			samplePath = json_string_value(samplePathJ);
+			// 加载补丁、粘贴或复制时由随后的 onAdd 开始解码；对已在引擎中的模块加载预设时直接开始
+			if (added)
+				decodeSavedSample();
 		}
+	}
 
-		// 从采样缓冲区读取（线性插值）
-		int idx0 = (int)grain.phase;
-		int idx1 = idx0 + 1;
-		float frac = grain.phase - idx0;
-		
-		if (idx1 >= sampleBufferSize) {
-			grain.active = false;
-			return 0.f;
+	// onset：颗粒起点相对当前采样的偏移（采样数，可为小数，> -1）
+	// 通过把初始 age/pos 往回推实现亚采样起点与延迟起点：age < 0 时窗函数为 0，颗粒尚未发声
+	void triggerGrain(float grainSize, float pitch, float vitality, float spread, float sampleTime, float onset) {
+		if (sampleBufferSize < 2) return;
+		// 颗粒池已满时丢弃本次触发
+		if (grains.count >= MAX_GRAINS) return;
+
+		int i = grains.count++;
+
+		// 计算起始位置：基础偏移 + Vitality 带来的抖动
+		float baseOffset = 0.1f * sampleDuration;
+		float jitter = vitality * sampleDuration * 0.4f;
+		float startPos = baseOffset + (random::uniform() - 0.5f) * jitter;
+		startPos = clamp(startPos, 0.f, sampleDuration - grainSize);
+		// 选择 mip 层：音高 < 1 读 2x 过采样层，音高 > √2 读半带低通层
+		int level = LEVEL_BASE;
+		float levelScale = 1.f;
+		if (pitch < 1.f && !sampleLevels[LEVEL_UP2X].empty()) {
+			level = LEVEL_UP2X;
+			levelScale = 2.f;
+		} else if (pitch > (float)M_SQRT2 && !sampleLevels[LEVEL_HALFBAND].empty()) {
+			level = LEVEL_HALFBAND;
+		}
+		// 将时间位置转换为采样索引，播放速度折算为每个引擎采样的索引增量
+		float samplesPerSecond = sampleBufferSize / sampleDuration * levelScale;
+		grains.inc[i] = pitch * samplesPerSecond * sampleTime;
+		grains.ageInc[i] = sampleTime / grainSize;
+		// processGrains 先推进再读取，因此多退一个采样
+		grains.pos[i] = startPos * samplesPerSecond - (1.f + onset) * grains.inc[i];
+		grains.age[i] = -(1.f + onset) * grains.ageInc[i];
+		grains.end[i] = (float)((int)sampleLevels[level].size() - 2);
+		grains.level[i] = level;
+
+		// 声像：Spread 越高，颗粒在立体声场中散布越宽（等功率，居中时左右增益均为 1）
+		float pan = (random::uniform() * 2.f - 1.f) * spread;
+		float theta = (pan + 1.f) * (float)M_PI * 0.25f;
+		grains.gainL[i] = std::cos(theta) * (float)M_SQRT2;
+		grains.gainR[i] = std::sin(theta) * (float)M_SQRT2;
+		// 每颗粒随机音色倾斜，范围随 Vitality 变化
+		grains.tilt[i] = grainTilt ? (random::uniform() * 2.f - 1.f) * vitality * 0.8f : 0.f;
+		grains.tiltZL[i] = 0.f;
+		grains.tiltZR[i] = 0.f;
+	}
+
+	// 实时模式：颗粒从捕获环中写入头之后 delay 秒处开始读取，Vitality 决定抖动范围
+	void triggerLiveGrain(float grainSize, float pitch, float vitality, float spread, float delay, float sampleRate, float onset) {
+		if (liveMask == 0) return;
+		if (grains.count >= MAX_GRAINS) return;
+
+		int i = grains.count++;
+
+		float grainSamples = grainSize * sampleRate;
+		float delaySamples = (delay + (random::uniform() - 0.5f) * vitality * LIVE_MAX_JITTER) * sampleRate;
+		// 音高 > 1 时颗粒会追向写入头，预留 (pitch - 1) * 颗粒长度避免读到未写入的数据；
+		// 同时不能超出捕获环，否则会读到被覆盖的数据
+		float minDelay = std::max(pitch - 1.f, 0.f) * grainSamples + 2.f;
+		// 延迟起点期间写入头继续前进，也要计入
+		float maxDelay = (float)liveMask - std::max(pitch, 1.f) * grainSamples - std::max(onset, 0.f) - 2.f;
+		delaySamples = clamp(delaySamples, minDelay, std::max(maxDelay, minDelay));
+
+		float start = (float)liveWrite - delaySamples;
+		if (start < 0.f)
+			start += (float)(liveMask + 1);
+		grains.inc[i] = pitch;
+		grains.ageInc[i] = 1.f / grainSamples;
+		// 起点之前 pos 可能为负，按掩码读取时自然回绕（此时包络为 0）
+		grains.pos[i] = start - (1.f + onset) * pitch;
+		grains.age[i] = -(1.f + onset) * grains.ageInc[i];
+		grains.end[i] = 0.f;
+		grains.level[i] = LEVEL_BASE;
+
+		// 立体声输入保留原声像，Spread 在此基础上随机偏移
+		float pan = (random::uniform() * 2.f - 1.f) * spread;
+		float theta = (pan + 1.f) * (float)M_PI * 0.25f;
+		grains.gainL[i] = std::cos(theta) * (float)M_SQRT2;
+		grains.gainR[i] = std::sin(theta) * (float)M_SQRT2;
+		// 每颗粒随机音色倾斜，范围随 Vitality 变化
+		grains.tilt[i] = grainTilt ? (random::uniform() * 2.f - 1.f) * vitality * 0.8f : 0.f;
+		grains.tiltZL[i] = 0.f;
+		grains.tiltZR[i] = 0.f;
+	}
+
+	// 实时模式下的颗粒渲染：左右声道分别从捕获环读取，索引按掩码回绕
+	// tiltCoef 为倾斜滤波器的一阶低通系数，0 表示关闭
+	void processLiveGrains(const float* window, float tiltCoef, float& outL, float& outR) {
+		outL = 0.f;
+		outR = 0.f;
+		if (grains.count == 0 || liveMask == 0) return;
+
+		const float* ringL = liveRingL.data();
+		const float* ringR = liveRingR.data();
+		float ringSize = (float)(liveMask + 1);
+		simd::float_4 sumL = 0.f;
+		simd::float_4 sumR = 0.f;
+
+		for (int i = 0; i < grains.count; i += 4) {
+			simd::float_4 age = simd::float_4::load(&grains.age[i]) + simd::float_4::load(&grains.ageInc[i]);
+			simd::float_4 pos = simd::float_4::load(&grains.pos[i]) + simd::float_4::load(&grains.inc[i]);
+			// 保持 pos 在 [0, ringSize) 内，避免长时间运行后浮点精度下降
+			pos = simd::ifelse(pos >= ringSize, pos - ringSize, pos);
+			age.store(&grains.age[i]);
+			pos.store(&grains.pos[i]);
+
+			simd::float_4 alive = (age < 1.f);
+
+			simd::float_4 w = simd::clamp(age, 0.f, 1.f) * (float)(GrainWindowTables::SIZE - 1);
+			simd::int32_4 widx = w;
+			simd::float_4 wfrac = w - simd::float_4(widx);
+			simd::int32_4 idx0 = pos;
+			simd::float_4 frac = pos - simd::float_4(idx0);
+			simd::float_4 w0, w1, l0, l1, r0, r1;
+			for (int k = 0; k < 4; k++) {
+				uint32_t a = (uint32_t)idx0[k] & liveMask;
+				uint32_t b = (a + 1) & liveMask;
+				w0[k] = window[widx[k]];
+				w1[k] = window[widx[k] + 1];
+				l0[k] = ringL[a];
+				l1[k] = ringL[b];
+				r0[k] = ringR[a];
+				r1[k] = ringR[b];
+			}
+			simd::float_4 env = simd::ifelse(alive, w0 + (w1 - w0) * wfrac, 0.f);
+			simd::float_4 sl = l0 + (l1 - l0) * frac;
+			simd::float_4 sr = r0 + (r1 - r0) * frac;
+			if (tiltCoef > 0.f) {
+				simd::float_4 t = simd::float_4::load(&grains.tilt[i]);
+				sl = applyTilt(sl, t, tiltCoef, &grains.tiltZL[i]);
+				sr = applyTilt(sr, t, tiltCoef, &grains.tiltZR[i]);
+			}
+			sumL += sl * env * simd::float_4::load(&grains.gainL[i]);
+			sumR += sr * env * simd::float_4::load(&grains.gainR[i]);
+		}
+		outL = sumL[0] + sumL[1] + sumL[2] + sumL[3];
+		outR = sumR[0] + sumR[1] + sumR[2] + sumR[3];
+
+		for (int i = 0; i < grains.count;) {
+			if (grains.age[i] >= 1.f)
+				grains.release(i);
+			else
+				i++;
+		}
+	}
+
+	// 一阶倾斜滤波：y = x + t * (x - 2 * lp)，t = -1 时只剩低频（+6dB），t = 1 时只剩高频，t = 0 时直通
+	static simd::float_4 applyTilt(simd::float_4 x, simd::float_4 t, float coef, float* z) {
+		simd::float_4 lp = simd::float_4::load(z);
+		lp += coef * (x - lp);
+		lp.store(z);
+		return x + t * (x - 2.f * lp);
+	}
+
+	// 4 个一组渲染所有活跃颗粒，累加到左右声道
+	// 包络从窗函数表按 age（每颗粒相位增量 ageInc）插值读取
+	void processGrains(const float* window, float tiltCoef, float& outL, float& outR) {
+		outL = 0.f;
+		outR = 0.f;
+		if (grains.count == 0 || sampleBufferSize < 2) return;
+
+		const float* bufs[NUM_LEVELS];
+		for (int l = 0; l < NUM_LEVELS; l++)
+			bufs[l] = sampleLevels[l].data();
+		simd::float_4 sumL = 0.f;
+		simd::float_4 sumR = 0.f;
+
+		for (int i = 0; i < grains.count; i += 4) {
+			simd::float_4 age = simd::float_4::load(&grains.age[i]) + simd::float_4::load(&grains.ageInc[i]);
+			simd::float_4 pos = simd::float_4::load(&grains.pos[i]) + simd::float_4::load(&grains.inc[i]);
+			age.store(&grains.age[i]);
+			pos.store(&grains.pos[i]);
+
+			// 超出范围的颗粒本帧静音并在下面回收（读取 idx0 + 1 需要留出一个采样）
+			simd::float_4 endPos = simd::float_4::load(&grains.end[i]);
+			simd::float_4 alive = (age < 1.f) & (pos < endPos);
+
+			// 线性插值读取采样与窗函数（逐通道 gather）
+			simd::float_4 w = simd::clamp(age, 0.f, 1.f) * (float)(GrainWindowTables::SIZE - 1);
+			simd::int32_4 widx = w;
+			simd::float_4 wfrac = w - simd::float_4(widx);
+			simd::float_4 p = simd::clamp(pos, 0.f, simd::fmax(endPos, 0.f));
+			simd::int32_4 idx0 = p;
+			simd::float_4 frac = p - simd::float_4(idx0);
+			simd::float_4 w0, w1, s0, s1;
+			for (int k = 0; k < 4; k++) {
+				const float* buf = bufs[grains.level[i + k]];
+				w0[k] = window[widx[k]];
+				w1[k] = window[widx[k] + 1];
+				s0[k] = buf[idx0[k]];
+				s1[k] = buf[idx0[k] + 1];
+			}
+			simd::float_4 env = simd::ifelse(alive, w0 + (w1 - w0) * wfrac, 0.f);
+			simd::float_4 s = s0 + (s1 - s0) * frac;
+			if (tiltCoef > 0.f)
+				s = applyTilt(s, simd::float_4::load(&grains.tilt[i]), tiltCoef, &grains.tiltZL[i]);
+			s *= env;
+			sumL += s * simd::float_4::load(&grains.gainL[i]);
+			sumR += s * simd::float_4::load(&grains.gainR[i]);
 		}
+		outL = sumL[0] + sumL[1] + sumL[2] + sumL[3];
+		outR = sumR[0] + sumR[1] + sumR[2] + sumR[3];
 
-		float sample = sampleBuffer[idx0] * (1.f - frac) + sampleBuffer[idx1] * frac;
-		return sample * grain.envelope;
+		// 回收结束的颗粒
+		for (int i = 0; i < grains.count;) {
+			if (grains.age[i] >= 1.f || grains.pos[i] >= grains.end[i])
+				grains.release(i);
+			else
+				i++;
+		}
 	}
 
 	void process(const ProcessArgs& args) override {
@@ -331,67 +839,145 @@ struct OrganicParticleSynth : Module {
 		float resonance = params[RESONANCE_PARAM].getValue();
 		float bpm = params[BPM_PARAM].getValue();
 		float volume = params[VOLUME_PARAM].getValue();
+		int windowType = clamp((int)std::round(params[WINDOW_PARAM].getValue()), 0, GrainWindowTables::NUM_TYPES - 1);
+
+		// 实时输入：写入捕获环（FREEZE 为高时保持环内容不变）
+		bool live = inputs[IN_L_INPUT].isConnected();
+		if (live != liveMode) {
+			// 切换采样/实时模式时颗粒的读取位置不再有效
+			liveMode = live;
+			grains.clear();
+		}
+		if (liveMode) {
+			bool frozen = inputs[FREEZE_INPUT].getVoltage() >= 1.f;
+			if (!frozen) {
+				float inL = inputs[IN_L_INPUT].getVoltage() / 5.f;
+				float inR = inputs[IN_R_INPUT].isConnected() ? inputs[IN_R_INPUT].getVoltage() / 5.f : inL;
+				liveRingL[liveWrite] = inL;
+				liveRingR[liveWrite] = inR;
+				liveWrite = (liveWrite + 1) & liveMask;
+			}
+		}
+		float liveDelay = params[LIVE_DELAY_PARAM].getValue();
+		float spread = params[SPREAD_PARAM].getValue();
+
+		// 采样模式：加载线程交换缓冲区时拿不到锁，本帧不触发也不渲染颗粒
+		// 实时模式只读捕获环，不需要加锁
+		std::unique_lock<std::mutex> sampleLock(sampleMutex, std::defer_lock);
+		bool sampleReady = liveMode || sampleLock.try_lock();
+		if (!liveMode && sampleReady && sampleChanged.exchange(false))
+			grains.clear();
+
+		auto spawnGrain = [&](float onset) {
+			if (!sampleReady) return;
+			if (liveMode)
+				triggerLiveGrain(grainSize, pitch, vitality, spread, liveDelay, args.sampleRate, onset);
+			else
+				triggerGrain(grainSize, pitch, vitality, spread, args.sampleTime, onset);
+		};
 
 		// 颗粒合成模式
-		// 使用连续调度算法（参考 Aetheria 实现）
-		float beatSec = 60.f / bpm;
+		// 调度点落在 nextGrainTime + k * grainInterval（采样，含小数），颗粒按亚采样偏移起振
+		double now = (double)sampleCounter;
 		float densityFactor = 1.f + density * 12.f;
-		float grainInterval = beatSec / densityFactor;
-		
-		// 检查外部时钟输入
+		// 节拍长度：有外部时钟且已测得周期时跟随时钟，否则使用 BPM
+		double beatSamples = 60.0 / bpm * args.sampleRate;
+
+		// 检查外部时钟输入；未接线时使用相邻 MidiClockSync 的走带
+		bool transportSync = transport.process(this, args.frame) && !inputs[CLOCK_INPUT].isConnected();
+		bool clockEdge = false;
+		double edgeTime = now;
 		if (inputs[CLOCK_INPUT].isConnected()) {
-			if (clockTrigger.process(inputs[CLOCK_INPUT].getVoltage())) {
-				// 外部时钟触发时，重置内部定时器并确保至少触发一个颗粒
-				grainTimer = 0.f;
-				triggerGrain(0.f, grainSize, pitch, vitality);
-			}
-			// 即使有外部时钟，也使用内部调度器来增加密度
-			grainTimer += args.sampleTime;
-			while (grainTimer >= grainInterval) {
-				grainTimer -= grainInterval;
-				// 使用密度作为触发概率
-				if (random::uniform() < density) {
-					triggerGrain(0.f, grainSize, pitch, vitality);
-				}
+			float clockVoltage = inputs[CLOCK_INPUT].getVoltage();
+			if (clockTrigger.process(clockVoltage)) {
+				// 在上一采样与当前采样之间插值出 1V 阈值的穿越时刻
+				double frac = 1.0;
+				if (clockVoltage > lastClockVoltage)
+					frac = clamp((1.f - lastClockVoltage) / (clockVoltage - lastClockVoltage), 0.f, 1.f);
+				edgeTime = now - 1.0 + frac;
+				if (lastClockEdge >= 0.0 && edgeTime > lastClockEdge)
+					clockPeriod = edgeTime - lastClockEdge;
+				lastClockEdge = edgeTime;
+				clockEdge = true;
 			}
+			lastClockVoltage = clockVoltage;
+			if (clockPeriod > 0.0)
+				beatSamples = clockPeriod;
 		} else {
-			// 仅使用内部 BPM 同步
-			grainTimer += args.sampleTime;
-			while (grainTimer >= grainInterval) {
-				grainTimer -= grainInterval;
-				// 使用密度作为触发概率
-				if (random::uniform() < density) {
-					triggerGrain(0.f, grainSize, pitch, vitality);
+			lastClockEdge = -1.0;
+			clockPeriod = 0.0;
+			if (transportSync) {
+				// 走带给出精确的拍长与亚采样拍位置，无需测量
+				if (transport.state.ticksPerSample > 0.0)
+					beatSamples = ClockTransport::TICKS_PER_BEAT / transport.state.ticksPerSample;
+				float offset = 0.f;
+				if (transport.crossed(ClockTransport::TICKS_PER_BEAT, &offset)) {
+					edgeTime = now - offset;
+					clockEdge = true;
 				}
 			}
 		}
 
-		// 处理所有活跃的颗粒
-		float output = 0.f;
-		for (int i = 0; i < MAX_GRAINS; i++) {
-			if (grains[i].active) {
-				output += processGrain(grains[i], args.sampleTime);
+		// 颗粒网格对齐到时钟沿；若上一个调度点离时钟沿不足半个间隔，视为同一拍，不重复触发
+		if (clockEdge) {
+			double interval = beatSamples / densityFactor;
+			if (edgeTime - lastGrainTime < 0.5 * interval) {
+				nextGrainTime = lastGrainTime + interval;
+			} else {
+				nextGrainTime = edgeTime;
+				forceNextGrain = true;
+			}
+		}
+
+		double grainInterval = beatSamples / densityFactor;
+		// 参数跳变（例如从很慢的 BPM 切到很快）后不追赶落后太多的调度点
+		if (nextGrainTime < now - grainInterval)
+			nextGrainTime = now;
+		while (nextGrainTime < now + 1.0) {
+			// 使用密度作为触发概率；时钟沿上的颗粒总是触发
+			if (forceNextGrain || random::uniform() < density) {
+				// 每颗粒起点抖动：Vitality 越高，最多向后推迟半个间隔
+				double jitter = random::uniform() * vitality * 0.5 * grainInterval;
+				spawnGrain((float)(nextGrainTime - now + jitter));
 			}
+			forceNextGrain = false;
+			lastGrainTime = nextGrainTime;
+			nextGrainTime += grainInterval;
 		}
+		sampleCounter++;
+
+		// 处理所有活跃的颗粒
+		float outL = 0.f, outR = 0.f;
+		const float* window = GrainWindowTables::get().tables[windowType];
+		float tiltCoef = grainTilt ? 1.f - std::exp(-2.f * (float)M_PI * TILT_FREQ * args.sampleTime) : 0.f;
+		if (liveMode)
+			processLiveGrains(window, tiltCoef, outL, outR);
+		else if (sampleReady)
+			processGrains(window, tiltCoef, outL, outR);
+		if (sampleLock.owns_lock())
+			sampleLock.unlock();
 		// 增加输出增益，确保有足够的音量
-		output *= 2.0f;
+		outL *= 2.0f;
+		outR *= 2.0f;
 
 		// 应用低通滤波器
 		// 截止频率映射：与参考代码一致，使用 40 * 400^cutoff
 		float cutoffFreq = 40.f * std::pow(400.f, cutoff);
 		float q = resonance * 20.f + vitality * 5.f;
-		filter.setParameters(dsp::BiquadFilter::LOWPASS, 
-			clamp(cutoffFreq / args.sampleRate, 0.f, 0.45f), 
-			clamp(q, 0.1f, 20.f), 
-			1.0f);
-		output = filter.process(output);
+		float fc = clamp(cutoffFreq / args.sampleRate, 0.f, 0.45f);
+		float fq = clamp(q, 0.1f, 20.f);
+		filter.setLowpass(fc, fq);
+		simd::float_4 filtered = filter.processLowpass(simd::float_4(outL, outR, 0.f, 0.f));
+		outL = filtered[0];
+		outR = filtered[1];
 
 		// 应用音量
-		output *= volume * 5.f; // 5V 输出范围
+		outL *= volume * 5.f; // 5V 输出范围
+		outR *= volume * 5.f;
 
-		// 输出到左右声道（单声道）
-		outputs[L_OUTPUT].setVoltage(output);
-		outputs[R_OUTPUT].setVoltage(output);
+		// 输出到左右声道（每个颗粒独立声像）
+		outputs[L_OUTPUT].setVoltage(outL);
+		outputs[R_OUTPUT].setVoltage(outR);
 		
 		// 更新指示灯
 		lights[SAMPLE_LOADED_LIGHT].setBrightness(sampleLoaded ? 1.f : 0.f);
@@ -414,8 +1000,8 @@ struct LoadSampleMenuItem : ui::MenuItem {
 	OrganicParticleSynth* module;
 	
 	void onAction(const ActionEvent& e) override {
-		// 使用 osdialog 打开文件选择对话框（只支持 WAV 格式）
-		osdialog_filters* filters = osdialog_filters_parse("WAV files:wav");
+		// 使用 osdialog 打开文件选择对话框（WAV / AIFF / FLAC）
+		osdialog_filters* filters = osdialog_filters_parse(AudioFileDecoder::DIALOG_FILTERS);
 		char* pathC = osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
 		if (filters) {
 			osdialog_filters_free(filters);
@@ -426,9 +1012,9 @@ struct LoadSampleMenuItem : ui::MenuItem {
 			
 			// 检查文件扩展名
 			std::string ext = system::getExtension(path);
-			if (ext != ".wav" && ext != ".WAV") {
+			if (!AudioFileDecoder::isSupportedExtension(ext)) {
 				// 显示错误消息
-				osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "只支持 WAV 格式文件。\n请使用未压缩的 WAV 文件（16-bit PCM）。");
+				osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "不支持的文件格式。\n请使用 WAV、AIFF 或 FLAC 文件。");
 				return;
 			}
 			
@@ -458,6 +1044,12 @@ struct OrganicParticleSynthWidget : ModuleWidget {
 		// 第二行：Grain Size、Density
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(9, 59 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::GRAIN_SIZE_PARAM));
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(22, 59 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::DENSITY_PARAM));
+		// 颗粒窗函数选择（Hann / Tukey / Gaussian / Expodec）
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(30.96, 59 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::WINDOW_PARAM));
+		// 实时输入延迟（在 FREEZE 输入上方）
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(30.96, 69.5 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::LIVE_DELAY_PARAM));
+		// 立体声散布（在采样指示灯与窗函数选择之间）
+		addParam(createParamCentered<Trimpot>(mm2px(Vec(30.96, 48.5 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::SPREAD_PARAM));
 
 		// 第三行：Cutoff、Resonance
 		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(9, 80 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::CUTOFF_PARAM));
@@ -475,6 +1067,10 @@ struct OrganicParticleSynthWidget : ModuleWidget {
 		// 输入
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(9, 115 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::CLOCK_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(22, 115 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::VITALITY_CV_INPUT));
+		// 实时音频输入（左在输入行，右在输出行右侧）与 FREEZE 门
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.96, 115 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::IN_L_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.96, 128 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::IN_R_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.96, 80 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::FREEZE_INPUT));
 
 		// 输出
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(9, 128 - VERTICAL_OFFSET_MM)), module, OrganicParticleSynth::L_OUTPUT));
@@ -490,6 +1086,16 @@ struct OrganicParticleSynthWidget : ModuleWidget {
 		LoadSampleMenuItem* loadItem = createMenuItem<LoadSampleMenuItem>("Load Sample File");
 		loadItem->module = module;
 		menu->addChild(loadItem);
+
+		// 高质量变调：额外生成 2x 过采样层与半带低通层（占用约 3 倍内存）
+		menu->addChild(createBoolMenuItem("HQ pitch (2x mip)", "",
+			[=]() { return module->hqPitch.load(); },
+			[=](bool enabled) { module->setHqPitch(enabled); }
+		));
+		// 保存补丁时附带采样副本，补丁可在其他机器上打开
+		menu->addChild(createBoolPtrMenuItem("Store sample in patch", "", &module->embedSample));
+		// 每颗粒随机音色倾斜（一阶滤波，随 Vitality 变化）
+		menu->addChild(createBoolPtrMenuItem("Per-grain tilt", "", &module->grainTilt));
 	}
 };
 
@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "ClockTransport.hpp"
 #include <dsp/ringbuffer.hpp>
 
 // Simple delay line implementation
@@ -34,6 +35,14 @@ struct DelayLine {
 		size_t readPos = (writePos - delay + size) % size;
 		return buffer[readPos];
 	}
+
+	// Linear interpolation between taps, for read positions that glide
+	float readFractional(float delay) {
+		delay = clamp(delay, 0.f, (float)(size - 2));
+		size_t whole = (size_t)delay;
+		float frac = delay - (float)whole;
+		return read(whole) + (read(whole + 1) - read(whole)) * frac;
+	}
 };
 
 // Simple reverb using multiple delay lines
@@ -133,9 +142,30 @@ struct StereoEffects : Module {
 	float echoFeedback = 0.0f;
 	
 	float sampleRate = 44100.f;
+	
+	// Tempo sync from an adjacent MidiClockSync: the time knobs snap to the nearest note length
+	ClockTransport::Receiver transport;
+	// On for new instances; patches saved without the option load with it off
+	bool tempoSync = true;
+	// Beat length measured from the transport, held while it is stopped. The MIDI PLL
+	// and the whole-sample Sync In period wobble a little on every tick, so it only
+	// follows the transport once they drift apart by more than SYNC_TEMPO_TOLERANCE
+	float syncBeatSeconds = 0.f;
+	static constexpr float SYNC_TEMPO_TOLERANCE = 0.005f;
+	// Delay and echo read positions in samples, gliding towards the set length
+	// (-1 until the first sample) so tempo and knob changes don't jump the tap
+	float delayPosition = -1.f;
+	float echoPosition = -1.f;
+	static constexpr float GLIDE_SECONDS = 0.05f;
+	static constexpr int NUM_SYNC_LENGTHS = 12;
+	// Note lengths in beats: 1/32, 1/16T, 1/16, 1/8T, 1/16., 1/8, 1/4T, 1/8., 1/4, 1/2T, 1/4., 1/2
+	static constexpr float SYNC_BEATS[NUM_SYNC_LENGTHS] = {
+		0.125f, 1.f / 6.f, 0.25f, 1.f / 3.f, 0.375f, 0.5f, 2.f / 3.f, 0.75f, 1.f, 4.f / 3.f, 1.5f, 2.f
+	};
 
 	StereoEffects() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		transport.attach(this);
 		configParam(LEVEL_PARAM, 0.f, 2.f, 1.f, "Level");
 		configButton(DELAY_ENABLE_PARAM, "Delay Enable");
 		configParam(DELAY_TIME_PARAM, 0.001f, 1.f, 0.3f, "Delay Time", " s");
@@ -172,6 +202,42 @@ struct StereoEffects : Module {
 		if (reverbR) delete reverbR;
 	}
 
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "tempoSync", json_boolean(tempoSync));
+		return rootJ;
+	}
+
+	void fromJson(json_t* rootJ) override {
+		// Patches from before tempo sync have no "tempoSync" key (or no data at all):
+		// keep their delay and echo times as saved
+		tempoSync = false;
+		Module::fromJson(rootJ);
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* tempoSyncJ = json_object_get(rootJ, "tempoSync");
+		if (tempoSyncJ)
+			tempoSync = json_boolean_value(tempoSyncJ);
+	}
+
+	// Closest note length to `seconds` (by ratio) that still fits in `maxSeconds`
+	static float syncTime(float seconds, float beatSeconds, float maxSeconds) {
+		float best = seconds;
+		float bestDistance = INFINITY;
+		for (int i = 0; i < NUM_SYNC_LENGTHS; i++) {
+			float t = SYNC_BEATS[i] * beatSeconds;
+			if (t > maxSeconds)
+				break;
+			float distance = std::fabs(std::log(t / seconds));
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = t;
+			}
+		}
+		return best;
+	}
+
 	void process(const ProcessArgs& args) override {
 		// Initialize reverb if needed
 		if (!reverbL) {
@@ -195,6 +261,25 @@ struct StereoEffects : Module {
 			inL = inR;
 		}
 		
+		// Beat length while synced to an adjacent MidiClockSync, 0 otherwise
+		// The period comes from the transport's tick rate: its BPM field is the knob value
+		// whenever MidiClockSync follows Sync In or its MIDI PLL is unlocked
+		float beatSeconds = 0.f;
+		if (transport.process(this, args.frame)) {
+			if (transport.state.ticksPerSample > 0.0) {
+				float measured = transport.periodSeconds(ClockTransport::TICKS_PER_BEAT, args.sampleTime);
+				if (std::fabs(measured - syncBeatSeconds) > SYNC_TEMPO_TOLERANCE * measured)
+					syncBeatSeconds = measured;
+			}
+			if (tempoSync)
+				beatSeconds = syncBeatSeconds;
+		} else {
+			syncBeatSeconds = 0.f;
+		}
+		
+		// One-pole glide of the read positions, about GLIDE_SECONDS to settle
+		float glide = std::min(args.sampleTime / GLIDE_SECONDS, 1.f);
+
 		// Process effects on both channels simultaneously
 		float outL = inL;
 		float outR = inR;
@@ -202,11 +287,14 @@ struct StereoEffects : Module {
 		// Delay effect - applied to both channels
 		if (params[DELAY_ENABLE_PARAM].getValue() > 0.5f) {
 			float delayTime = params[DELAY_TIME_PARAM].getValue();
+			if (beatSeconds > 0.f)
+				delayTime = syncTime(delayTime, beatSeconds, 1.f);
 			float feedback = params[DELAY_FEEDBACK_PARAM].getValue();
-			size_t delaySamples = (size_t)(delayTime * args.sampleRate);
+			float delaySamples = delayTime * args.sampleRate;
+			delayPosition = delayPosition < 0.f ? delaySamples : delayPosition + (delaySamples - delayPosition) * glide;
 			
-			float delayedL = delayLineL->read(delaySamples);
-			float delayedR = delayLineR->read(delaySamples);
+			float delayedL = delayLineL->readFractional(delayPosition);
+			float delayedR = delayLineR->readFractional(delayPosition);
 			
 			outL += delayedL;
 			outR += delayedR;
@@ -240,11 +328,14 @@ struct StereoEffects : Module {
 		// Echo effect - applied to both channels
 		if (params[ECHO_ENABLE_PARAM].getValue() > 0.5f) {
 			float echoTime = params[ECHO_TIME_PARAM].getValue();
+			if (beatSeconds > 0.f)
+				echoTime = syncTime(echoTime, beatSeconds, 0.5f);
 			float feedback = params[ECHO_FEEDBACK_PARAM].getValue();
-			size_t echoSamples = (size_t)(echoTime * args.sampleRate);
+			float echoSamples = echoTime * args.sampleRate;
+			echoPosition = echoPosition < 0.f ? echoSamples : echoPosition + (echoSamples - echoPosition) * glide;
 			
-			float echoL = echoLineL->read(echoSamples);
-			float echoR = echoLineR->read(echoSamples);
+			float echoL = echoLineL->readFractional(echoPosition);
+			float echoR = echoLineR->readFractional(echoPosition);
 			
 			outL += echoL * 0.5f;
 			outR += echoR * 0.5f;
@@ -339,7 +430,17 @@ struct StereoEffectsWidget : ModuleWidget {
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(panelCenterX - portSpacing, 115.0)), module, StereoEffects::LEFT_OUTPUT));
 		addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(panelCenterX + portSpacing, 115.0)), module, StereoEffects::RIGHT_OUTPUT));
 	}
+
+	void appendContextMenu(Menu* menu) override {
+		StereoEffects* module = getModule<StereoEffects>();
+		if (!module)
+			return;
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createBoolPtrMenuItem("Sync delay/echo to adjacent MIDI Clock Sync", "", &module->tempoSync));
+	}
 };
 
+constexpr float StereoEffects::SYNC_BEATS[];
+
 Model* modelStereoEffects = createModel<StereoEffects, StereoEffectsWidget>("StereoEffects");
 
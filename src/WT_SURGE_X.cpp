@@ -1,4 +1,6 @@
 #include "plugin.hpp"
+#include "AudioFileDecoder.hpp"
+#include "FastMath.hpp"
 #include <osdialog.h>
 #include <cmath>
 #include <cstring>
@@ -6,6 +8,7 @@
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <thread>
 
 // --- Wavetable constants ---
 static constexpr int TABLE_SIZE = 2048;
@@ -22,61 +25,13 @@ enum WarpMode {
 	WARP_SYNC_LIKE = 4
 };
 
-// --- WAV parser: minimal PCM16/float32, stereo→mono avg ---
+// --- Wavetable file loader: decode (WAV/AIFF/FLAC), mix to mono, fit to frames ---
 struct WavParser {
 	static bool load(const std::string& path, std::vector<float>& out, int targetLen, int targetFrames) {
-		FILE* f = std::fopen(path.c_str(), "rb");
-		if (!f) return false;
-		char riff[4], fmt[4];
-		uint32_t chunkSize, subchunk1Size;
-		uint16_t audioFormat, numChannels;
-		uint32_t sampleRate, byteRate;
-		uint16_t blockAlign, bitsPerSample;
-		std::fread(riff, 1, 4, f);
-		if (std::memcmp(riff, "RIFF", 4) != 0) { std::fclose(f); return false; }
-		std::fread(&chunkSize, 4, 1, f);
-		std::fread(fmt, 1, 4, f);
-		if (std::memcmp(fmt, "WAVE", 4) != 0) { std::fclose(f); return false; }
-		std::fread(fmt, 1, 4, f);
-		std::fread(&subchunk1Size, 4, 1, f);
-		std::fread(&audioFormat, 2, 1, f);
-		std::fread(&numChannels, 2, 1, f);
-		std::fread(&sampleRate, 4, 1, f);
-		std::fread(&byteRate, 4, 1, f);
-		std::fread(&blockAlign, 2, 1, f);
-		std::fread(&bitsPerSample, 2, 1, f);
-		char dataId[4];
-		uint32_t dataSize;
-		while (std::fread(dataId, 1, 4, f) == 4) {
-			std::fread(&dataSize, 4, 1, f);
-			if (std::memcmp(dataId, "data", 4) == 0) break;
-			std::fseek(f, (long)dataSize, SEEK_CUR);
-		}
-		if (std::memcmp(dataId, "data", 4) != 0) { std::fclose(f); return false; }
-		int bytesPerSample = bitsPerSample / 8;
-		int totalSamples = (int)(dataSize / (bytesPerSample * std::max(1, (int)numChannels)));
+		AudioFileDecoder::Audio audio;
+		if (!AudioFileDecoder::decode(path, audio)) return false;
 		std::vector<float> raw;
-		raw.resize(totalSamples * (int)numChannels);
-		if (audioFormat == 1 && bitsPerSample == 16) {
-			for (size_t i = 0; i < raw.size(); i++) {
-				int16_t s;
-				if (std::fread(&s, 2, 1, f) != 1) break;
-				raw[i] = (float)s / 32768.f;
-			}
-		} else if (audioFormat == 3 && bitsPerSample == 32) {
-			for (size_t i = 0; i < raw.size(); i++) {
-				float s;
-				if (std::fread(&s, 4, 1, f) != 1) break;
-				raw[i] = s;
-			}
-		} else { std::fclose(f); return false; }
-		std::fclose(f);
-		if (numChannels == 2) {
-			std::vector<float> mono(totalSamples);
-			for (int i = 0; i < totalSamples; i++)
-				mono[i] = 0.5f * (raw[i * 2] + raw[i * 2 + 1]);
-			raw = std::move(mono);
-		}
+		AudioFileDecoder::mixToMono(audio, raw);
 		int wantLen = targetLen * targetFrames;
 		if ((int)raw.size() >= wantLen) {
 			out.resize(wantLen);
@@ -116,6 +71,12 @@ struct WavetableBank {
 	float tables[NUM_BANKS][NUM_FRAMES][MIP_LEVELS][TABLE_SIZE];
 	std::atomic<bool> tableReady{true};
 	std::mutex loadMutex;
+	std::thread loaderThread;
+
+	~WavetableBank() {
+		if (loaderThread.joinable())
+			loaderThread.join();
+	}
 
 	void generateDefault() {
 		for (int bank = 0; bank < NUM_BANKS; bank++) {
@@ -170,25 +131,33 @@ struct WavetableBank {
 		}
 	}
 
+	// Decode on a worker thread so large/compressed files don't stall the UI
+	void loadWavAsync(int bank, const std::string& path) {
+		if (loaderThread.joinable())
+			loaderThread.join();
+		loaderThread = std::thread([this, bank, path]() {
+			loadWav(bank, path);
+		});
+	}
+
 	void loadWav(int bank, const std::string& path) {
+		std::vector<float> buf;
+		if (!WavParser::load(path, buf, TABLE_SIZE, NUM_FRAMES)) return;
 		std::lock_guard<std::mutex> lock(loadMutex);
 		tableReady = false;
-		std::vector<float> buf;
-		if (WavParser::load(path, buf, TABLE_SIZE, NUM_FRAMES)) {
-			for (int f = 0; f < NUM_FRAMES; f++) {
-				for (int s = 0; s < TABLE_SIZE; s++)
-					tables[bank][f][0][s] = buf[f * TABLE_SIZE + s];
-				for (int mip = 1; mip < MIP_LEVELS; mip++) {
-					int step = 1 << mip;
-					for (int s = 0; s < TABLE_SIZE; s++) {
-						float sum = 0.f; int n = 0;
-						for (int k = s - step / 2; k <= s + step / 2; k += step) {
-							int idx = (k % TABLE_SIZE + TABLE_SIZE) % TABLE_SIZE;
-							sum += tables[bank][f][0][idx];
-							n++;
-						}
-						tables[bank][f][mip][s] = (n > 0) ? (sum / (float)n) : tables[bank][f][mip - 1][s];
+		for (int f = 0; f < NUM_FRAMES; f++) {
+			for (int s = 0; s < TABLE_SIZE; s++)
+				tables[bank][f][0][s] = buf[f * TABLE_SIZE + s];
+			for (int mip = 1; mip < MIP_LEVELS; mip++) {
+				int step = 1 << mip;
+				for (int s = 0; s < TABLE_SIZE; s++) {
+					float sum = 0.f; int n = 0;
+					for (int k = s - step / 2; k <= s + step / 2; k += step) {
+						int idx = (k % TABLE_SIZE + TABLE_SIZE) % TABLE_SIZE;
+						sum += tables[bank][f][0][idx];
+						n++;
 					}
+					tables[bank][f][mip][s] = (n > 0) ? (sum / (float)n) : tables[bank][f][mip - 1][s];
 				}
 			}
 		}
@@ -309,13 +278,13 @@ struct WT_SURGE_X : Module {
 			case WARP_PHASE_DISTORT: {
 				float p = phase;
 				float k = 0.5f + amount * 1.5f;
-				p = std::pow(p, k);
-				warped = std::sin(2.f * M_PI * p) * 0.9f;
+				p = FastMath::exp2(k * FastMath::log2(std::max(p, 1e-9f)));
+				warped = FastMath::sin2pi(p) * 0.9f;
 				break;
 			}
 			case WARP_BEND_ASYM: {
 				float b = 1.f + amount * 3.f;
-				warped = std::tanh(sample * b);
+				warped = FastMath::tanh(sample * b);
 				break;
 			}
 			case WARP_MIRROR: {
@@ -335,8 +304,7 @@ struct WT_SURGE_X : Module {
 			case WARP_SYNC_LIKE: {
 				float mult = 1.f + amount * 7.f;
 				float p = phase * mult;
-				p = p - std::floor(p);
-				warped = std::sin(2.f * M_PI * p) * 0.9f;
+				warped = FastMath::sin2pi(p) * 0.9f;
 				break;
 			}
 			default: break;
@@ -363,7 +331,7 @@ struct WT_SURGE_X : Module {
 		if (inputs[FM_INPUT].isConnected())
 			fm = inputs[FM_INPUT].getVoltage() * fmAmt * 12.f;
 		float pitch = pitchV + coarse + fine + fm;
-		float freqHz = dsp::FREQ_C4 * std::pow(2.f, pitch / 12.f);
+		float freqHz = dsp::FREQ_C4 * FastMath::exp2(pitch / 12.f);
 		freqHz = math::clamp(freqHz, 1.f, 20000.f);
 
 		float xPos = params[X_POS_PARAM].getValue();
@@ -409,7 +377,7 @@ struct WT_SURGE_X : Module {
 
 		for (int v = 0; v < voices; v++) {
 			float detuneCents = (v - (voices - 1) * 0.5f) * detune * 30.f;
-			float vFreq = freqHz * std::pow(2.f, detuneCents / 12.f);
+			float vFreq = freqHz * FastMath::exp2(detuneCents / 12.f);
 			float inc = vFreq * args.sampleTime;
 
 			if (sync) phaseStore[v] = phaseStart;
@@ -513,13 +481,13 @@ struct WT_SURGE_XWidget : ModuleWidget {
 		WT_SURGE_X* mod;
 		int bank;
 		void onAction(const ActionEvent& e) override {
-			osdialog_filters* filters = osdialog_filters_parse("WAV files:wav");
+			osdialog_filters* filters = osdialog_filters_parse(AudioFileDecoder::DIALOG_FILTERS);
 			char* pathC = osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
 			if (filters) osdialog_filters_free(filters);
 			if (pathC) {
 				std::string path = pathC;
 				std::free(pathC);
-				mod->wavetable.loadWav(bank, path);
+				mod->wavetable.loadWavAsync(bank, path);
 			}
 		}
 	};
@@ -0,0 +1,93 @@
+// Sweeps every FastMath function over its documented domain against the
+// double-precision libm result, for both the float and simd::float_4
+// instantiations, and fails if any error exceeds the bound stated in
+// src/FastMath.hpp. Run with `make test`.
+#include "FastMath.hpp"
+#include <cmath>
+#include <cstdio>
+
+static const int POINTS = 1 << 24;
+
+enum ErrorKind { ABSOLUTE, RELATIVE };
+
+static int failures = 0;
+
+// `F` is called with float and with simd::float_4; `ref` is the libm reference
+template <typename F, typename R>
+static void sweep(const char* name, double lo, double hi, bool logSpaced, ErrorKind kind, double bound, F f, R ref) {
+	double maxScalar = 0.0;
+	double maxVector = 0.0;
+	double worstX = lo;
+	for (int i = 0; i < POINTS; i += 4) {
+		alignas(16) float x[4];
+		for (int k = 0; k < 4; k++) {
+			double t = (double)(i + k) / (double)(POINTS - 1);
+			x[k] = logSpaced
+				? (float)std::exp(std::log(lo) + t * (std::log(hi) - std::log(lo)))
+				: (float)(lo + t * (hi - lo));
+		}
+		alignas(16) float y[4];
+		f(simd::float_4::load(x)).store(y);
+		for (int k = 0; k < 4; k++) {
+			double expected = ref((double)x[k]);
+			double scale = kind == RELATIVE ? std::fabs(expected) : 1.0;
+			double errScalar = std::fabs((double)f(x[k]) - expected) / scale;
+			double errVector = std::fabs((double)y[k] - expected) / scale;
+			if (errScalar > maxScalar) {
+				maxScalar = errScalar;
+				worstX = x[k];
+			}
+			if (errVector > maxVector)
+				maxVector = errVector;
+		}
+	}
+	bool ok = maxScalar < bound && maxVector < bound;
+	if (!ok)
+		failures++;
+	std::printf("%-5s %-10s [%g, %g] %s error: float %.3g, float_4 %.3g (bound %.3g, worst at x = %g)\n",
+		ok ? "ok" : "FAIL", name, lo, hi, kind == RELATIVE ? "rel" : "abs", maxScalar, maxVector, bound, worstX);
+}
+
+// Generic lambdas need C++14, so each function gets a small functor
+#define FAST_MATH_FUNCTOR(fn) \
+	struct fn##Functor { \
+		float operator()(float x) const { return FastMath::fn(x); } \
+		simd::float_4 operator()(simd::float_4 x) const { return FastMath::fn(x); } \
+	}
+
+FAST_MATH_FUNCTOR(sin2pi);
+FAST_MATH_FUNCTOR(cos2pi);
+FAST_MATH_FUNCTOR(exp2);
+FAST_MATH_FUNCTOR(log2);
+FAST_MATH_FUNCTOR(tanh);
+FAST_MATH_FUNCTOR(softClip);
+
+static double refSin2pi(double x) { return std::sin(2.0 * M_PI * x); }
+static double refCos2pi(double x) { return std::cos(2.0 * M_PI * x); }
+static double refExp2(double x) { return std::exp2(x); }
+static double refLog2(double x) { return std::log2(x); }
+static double refTanh(double x) { return std::tanh(x); }
+
+int main() {
+	sweep("sin2pi", -64.0, 64.0, false, ABSOLUTE, 2.0e-7, sin2piFunctor(), refSin2pi);
+	sweep("cos2pi", -64.0, 64.0, false, ABSOLUTE, 2.0e-7, cos2piFunctor(), refCos2pi);
+	sweep("exp2", -126.0, 126.0, false, RELATIVE, 1.5e-7, exp2Functor(), refExp2);
+	sweep("log2", 0.5, 2.0, false, ABSOLUTE, 2.0e-7, log2Functor(), refLog2);
+	sweep("log2", 1e-30, 0.5, true, RELATIVE, 1.5e-7, log2Functor(), refLog2);
+	sweep("log2", 2.0, 1e30, true, RELATIVE, 1.5e-7, log2Functor(), refLog2);
+	sweep("tanh", -20.0, 20.0, false, ABSOLUTE, 2.5e-7, tanhFunctor(), refTanh);
+	sweep("softClip", -20.0, 20.0, false, ABSOLUTE, 0.024, softClipFunctor(), refTanh);
+
+	// softClip saturates exactly at +-1 from |x| = 3
+	softClipFunctor softClip;
+	bool saturated = softClip(3.f) == 1.f && softClip(-3.f) == -1.f && softClip(100.f) == 1.f;
+	std::printf("%-5s softClip saturation\n", saturated ? "ok" : "FAIL");
+	if (!saturated)
+		failures++;
+
+	if (failures > 0) {
+		std::printf("%d FastMath check(s) failed\n", failures);
+		return 1;
+	}
+	return 0;
+}